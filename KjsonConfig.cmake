@@ -3,4 +3,5 @@ include("${CMAKE_CURRENT_LIST_DIR}/KjsonTargets.cmake")
 find_package(Results CONFIG REQUIRED)
 find_package(Kb64 CONFIG REQUIRED)
 find_package(Composite CONFIG REQUIRED)
+find_package(Threads REQUIRED)
 
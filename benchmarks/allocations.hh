@@ -0,0 +1,22 @@
+#pragma once
+
+#ifdef KJSON_COUNT_ALLOCATIONS
+// counted by the kjson_allocations objects linked into alloc_benchmarks
+#include "stats/allocations.hh"
+#else
+#include <cstddef>
+
+namespace kjson {
+
+// Always zero: the plain benchmarks do not replace operator new.
+struct allocation_count {
+    std::size_t count;
+    std::size_t bytes;
+
+    static allocation_count now() {
+        return {0, 0};
+    }
+};
+
+}
+#endif
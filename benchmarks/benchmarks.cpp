@@ -1,9 +1,13 @@
 #include <benchmark/benchmark.h>
 #include <type_traits>
+#include "allocations.hh"
+#include "corpus.hh"
 #include "json.hh"
 #include "visitor.hh"
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
 
 namespace kjson {
 namespace {
@@ -44,45 +48,141 @@ public:
     {}
 };
 
-document sample_as_doc() {
-    return load(sample).expect("invalid json");
+using corpus_t = const std::string& (*)();
+
+const std::string& small() {
+    static const std::string data = sample;
+    return data;
+}
+
+// bytes/s and documents/s, plus allocations per document since start when
+// they are counted
+void report(benchmark::State &state, size_t bytes, size_t documents, allocation_count start) {
+    auto end = allocation_count::now();
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * documents);
+#ifdef KJSON_COUNT_ALLOCATIONS
+    double processed = static_cast<double>(state.iterations() * documents);
+    state.counters["allocs_per_doc"] = (end.count - start.count) / processed;
+    state.counters["alloc_bytes_per_doc"] = (end.bytes - start.bytes) / processed;
+#else
+    (void)end;
+    (void)start;
+#endif
+}
+
+size_t dumped_size(const document &doc) {
+    std::ostringstream out;
+    dump(doc, out);
+    return out.str().size();
+}
+
+void bm_load(benchmark::State &state, corpus_t corpus) {
+    auto &text = corpus();
+
+    auto start = allocation_count::now();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(load(text).expect("valid json"));
+    }
+    report(state, text.size(), 1, start);
+}
+
+void bm_load_parse_only(benchmark::State &state, corpus_t corpus) {
+    auto &text = corpus();
+    null_visitor v;
+
+    auto start = allocation_count::now();
+    for (auto _ : state) {
+        load(text, v).expect("valid json");
+    }
+    report(state, text.size(), 1, start);
+}
+
+void bm_dump(benchmark::State &state, corpus_t corpus) {
+    auto doc = load(corpus()).expect("valid json");
+    auto bytes = dumped_size(doc);
+    std::ofstream out("/dev/null");
+
+    auto start = allocation_count::now();
+    for (auto _ : state) {
+        dump(doc, out);
+    }
+    report(state, bytes, 1, start);
 }
 
-void bm_load(benchmark::State &state) {
-    std::istringstream stream{sample};
+#define KJSON_CORPUS_BENCHMARKS(name)                          \
+    BENCHMARK_CAPTURE(bm_load, name, name);                    \
+    BENCHMARK_CAPTURE(bm_load_parse_only, name, name);         \
+    BENCHMARK_CAPTURE(bm_dump, name, name)
+
+using namespace corpus;
+
+KJSON_CORPUS_BENCHMARKS(small);
+KJSON_CORPUS_BENCHMARKS(twitter);
+KJSON_CORPUS_BENCHMARKS(geojson);
+KJSON_CORPUS_BENCHMARKS(deep);
+KJSON_CORPUS_BENCHMARKS(long_strings);
+KJSON_CORPUS_BENCHMARKS(flat_array);
+KJSON_CORPUS_BENCHMARKS(wide_object);
+
+size_t total_size(const std::vector<std::string> &lines) {
+    size_t bytes = 0;
+    for (auto &line : lines) {
+        bytes += line.size() + 1;
+    }
+    return bytes;
+}
 
+void bm_load_ndjson(benchmark::State &state) {
+    auto &lines = ndjson();
+
+    auto start = allocation_count::now();
     for (auto _ : state) {
-        load(stream).expect("valid json");
-        stream.clear();
-        stream.seekg(0);
+        for (auto &line : lines) {
+            benchmark::DoNotOptimize(load(line).expect("valid json"));
+        }
     }
+    report(state, total_size(lines), lines.size(), start);
 }
 
-BENCHMARK(bm_load);
+BENCHMARK(bm_load_ndjson);
 
-void bm_load_parse_only(benchmark::State &state) {
-    std::istringstream stream{sample};
+void bm_load_parse_only_ndjson(benchmark::State &state) {
+    auto &lines = ndjson();
     null_visitor v;
 
+    auto start = allocation_count::now();
     for (auto _ : state) {
-        load(stream, v).expect("valid json");
-        stream.clear();
-        stream.seekg(0);
+        for (auto &line : lines) {
+            load(line, v).expect("valid json");
+        }
     }
+    report(state, total_size(lines), lines.size(), start);
 }
 
-BENCHMARK(bm_load_parse_only);
+BENCHMARK(bm_load_parse_only_ndjson);
 
-void bm_dump(benchmark::State &state) {
-    auto doc = sample_as_doc();
+void bm_dump_ndjson(benchmark::State &state) {
+    std::vector<document> docs;
+    size_t bytes = 0;
+    for (auto &line : ndjson()) {
+        docs.push_back(load(line).expect("valid json"));
+        bytes += dumped_size(docs.back()) + 1;
+    }
     std::ofstream out("/dev/null");
 
+    auto start = allocation_count::now();
     for (auto _ : state) {
-        dump(doc, out);
+        for (auto &doc : docs) {
+            dump(doc, out);
+            out.put('\n');
+        }
     }
+    report(state, bytes, docs.size(), start);
 }
 
-BENCHMARK(bm_dump);
+BENCHMARK(bm_dump_ndjson);
 
 }
 }
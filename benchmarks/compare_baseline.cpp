@@ -0,0 +1,184 @@
+// Compares the JSON output of alloc_benchmarks against a baseline and fails
+// when allocations per document grow or throughput drops past a threshold.
+//
+//   alloc_benchmarks --benchmark_out=current.json --benchmark_out_format=json
+//   compare_baseline [--allocations=0.01] [--throughput=0.10] baseline.json current.json
+#include "json.hh"
+#include "visitor.hh"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace kjson {
+namespace {
+
+using metrics = std::map<std::string, double>;
+using runs = std::map<std::string, metrics>;
+
+// collects the name and numeric fields of every entry of "benchmarks"
+class runs_visitor : public visitor {
+public:
+    explicit runs_visitor(runs &out)
+        : d_runs(out)
+    {}
+
+    void scalar(scalar_t) override
+    {}
+
+    void scalar(std::string_view key, scalar_t v) override {
+        if (d_depth != 3 || !d_in_benchmarks) {
+            return;
+        }
+        if (auto s = std::get_if<std::string>(&v); s && key == "name") {
+            d_name = *s;
+        } else if (auto d = std::get_if<double>(&v)) {
+            d_metrics[std::string(key)] = *d;
+        } else if (auto i = std::get_if<int64_t>(&v)) {
+            d_metrics[std::string(key)] = static_cast<double>(*i);
+        } else if (auto u = std::get_if<uint64_t>(&v)) {
+            d_metrics[std::string(key)] = static_cast<double>(*u);
+        }
+    }
+
+    void push_mapping() override {
+        ++d_depth;
+    }
+
+    void push_mapping(std::string_view) override {
+        ++d_depth;
+    }
+
+    void push_sequence() override {
+        ++d_depth;
+    }
+
+    void push_sequence(std::string_view key) override {
+        d_in_benchmarks = d_depth == 1 && key == "benchmarks";
+        ++d_depth;
+    }
+
+    void pop() override {
+        if (d_depth == 3 && d_in_benchmarks && !d_name.empty()) {
+            d_runs[d_name] = std::move(d_metrics);
+        }
+        if (d_depth == 3) {
+            d_name.clear();
+            d_metrics.clear();
+        }
+        if (d_depth == 2) {
+            d_in_benchmarks = false;
+        }
+        --d_depth;
+    }
+
+private:
+    runs &d_runs;
+    int d_depth{0};
+    bool d_in_benchmarks{false};
+    std::string d_name;
+    metrics d_metrics;
+};
+
+bool read_runs(const char *path, runs &out) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << path << ": can not open\n";
+        return false;
+    }
+
+    runs_visitor v(out);
+    try {
+        load(in, v).unwrap();
+    } catch (const std::exception &e) {
+        std::cerr << path << ": " << e.what() << '\n';
+        return false;
+    }
+    return true;
+}
+
+struct gate {
+    const char *metric;
+    bool higher_is_better;
+    double threshold;
+};
+
+// returns the number of regressions
+int compare(const runs &baseline, const runs &current, const std::vector<gate> &gates) {
+    int regressions = 0;
+    for (auto &[name, expected] : baseline) {
+        auto it = current.find(name);
+        if (it == current.end()) {
+            std::cout << "skipped    " << name << ": not run\n";
+            continue;
+        }
+
+        for (auto &g : gates) {
+            auto e = expected.find(g.metric);
+            auto a = it->second.find(g.metric);
+            if (e == expected.end() || a == it->second.end()) {
+                continue;
+            }
+
+            bool regressed = g.higher_is_better
+                ? a->second < e->second * (1 - g.threshold)
+                : a->second > e->second * (1 + g.threshold);
+            if (regressed) {
+                std::cout << "REGRESSION " << name << ": " << g.metric << " " << e->second << " -> " << a->second << '\n';
+                ++regressions;
+            }
+        }
+    }
+
+    for (auto &run : current) {
+        if (!baseline.count(run.first)) {
+            std::cout << "new        " << run.first << ": not in the baseline\n";
+        }
+    }
+    return regressions;
+}
+
+bool threshold(const std::string &arg, const std::string &option, double &out) {
+    if (arg.compare(0, option.size(), option) != 0) {
+        return false;
+    }
+    out = std::strtod(arg.c_str() + option.size(), nullptr);
+    return true;
+}
+
+}
+}
+
+int main(int argc, char **argv) {
+    using namespace kjson;
+
+    double allocations = 0.01;
+    double throughput = 0.10;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (!threshold(arg, "--allocations=", allocations) && !threshold(arg, "--throughput=", throughput)) {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.size() != 2) {
+        std::cerr << "usage: " << argv[0] << " [--allocations=0.01] [--throughput=0.10] baseline.json current.json\n";
+        return 2;
+    }
+
+    runs baseline, current;
+    if (!read_runs(files[0], baseline) || !read_runs(files[1], current)) {
+        return 2;
+    }
+
+    int regressions = compare(baseline, current, {
+        {"allocs_per_doc", false, allocations},
+        {"alloc_bytes_per_doc", false, allocations},
+        {"items_per_second", true, throughput},
+    });
+    std::cout << regressions << " regression(s) against " << files[0] << '\n';
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+#include <benchmark/benchmark.h>
+#include "builder.hh"
+#include "escape.hh"
+#include "parser.hh"
+#include "tokenizer.hh"
+#include "view_buffer.hh"
+#include "visitor.hh"
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace kjson {
+namespace {
+
+// Discards output without the cost of a system call.
+class null_buffer : public std::streambuf {
+protected:
+    int_type overflow(int_type c) override {
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        return n;
+    }
+};
+
+void bm_next_token(benchmark::State &state, const char *text) {
+    view_buffer buf(text);
+    token t;
+
+    for (auto _ : state) {
+        buf.reset(text);
+        next_token(buf, t).expect("valid token");
+        benchmark::DoNotOptimize(t.value.data());
+    }
+}
+
+BENCHMARK_CAPTURE(bm_next_token, start_mapping, "{");
+BENCHMARK_CAPTURE(bm_next_token, end_mapping, "}");
+BENCHMARK_CAPTURE(bm_next_token, start_sequence, "[");
+BENCHMARK_CAPTURE(bm_next_token, end_sequence, "]");
+BENCHMARK_CAPTURE(bm_next_token, separator, ",");
+BENCHMARK_CAPTURE(bm_next_token, mapper, ":");
+BENCHMARK_CAPTURE(bm_next_token, string, R"("the quick brown fox jumps")");
+BENCHMARK_CAPTURE(bm_next_token, escaped_string, R"("the \"quick\"\né😀 fox")");
+BENCHMARK_CAPTURE(bm_next_token, int, "-1234567");
+BENCHMARK_CAPTURE(bm_next_token, uint, "12345678901234");
+BENCHMARK_CAPTURE(bm_next_token, float, "-65.613616999999977e-3");
+BENCHMARK_CAPTURE(bm_next_token, true, "true");
+BENCHMARK_CAPTURE(bm_next_token, false, "false");
+BENCHMARK_CAPTURE(bm_next_token, null, "null");
+BENCHMARK_CAPTURE(bm_next_token, leading_whitespace, "  \n\t  1");
+
+std::string clean_text() {
+    std::string s;
+    while (s.size() < 1024) {
+        s += "plain text without anything to escape ";
+    }
+    return s;
+}
+
+std::string escape_heavy_text() {
+    std::string s;
+    while (s.size() < 1024) {
+        s += "a\"b\\c\nd\te/";
+    }
+    return s;
+}
+
+void bm_escape(benchmark::State &state, std::string (*make)()) {
+    auto input = make();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(escape(input));
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+BENCHMARK_CAPTURE(bm_escape, clean, clean_text);
+BENCHMARK_CAPTURE(bm_escape, escape_heavy, escape_heavy_text);
+
+void bm_iescape(benchmark::State &state, std::string (*make)()) {
+    auto input = make();
+    std::string s;
+
+    for (auto _ : state) {
+        s = input;
+        iescape(s);
+        benchmark::DoNotOptimize(s.data());
+    }
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+BENCHMARK_CAPTURE(bm_iescape, clean, clean_text);
+BENCHMARK_CAPTURE(bm_iescape, escape_heavy, escape_heavy_text);
+
+void bm_as_int(benchmark::State &state) {
+    raw_number n{"-1234567890123"};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(n.as_int());
+    }
+}
+
+BENCHMARK(bm_as_int);
+
+void bm_as_uint(benchmark::State &state) {
+    raw_number n{"18446744073709551615"};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(n.as_uint());
+    }
+}
+
+BENCHMARK(bm_as_uint);
+
+void bm_as_float(benchmark::State &state) {
+    raw_number n{"-65.613616999999977"};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(n.as_float());
+    }
+}
+
+BENCHMARK(bm_as_float);
+
+void bm_number_value(benchmark::State &state) {
+    raw_number n{"43.420273000000009"};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(n.value());
+    }
+}
+
+BENCHMARK(bm_number_value);
+
+// one scalar per iteration appended to a sequence; the argument is compact
+template <typename F>
+void builder_benchmark(benchmark::State &state, F &&with) {
+    null_buffer buf;
+    std::ostream out(&buf);
+    builder b(out, state.range(0) != 0);
+    b.push_sequence();
+
+    for (auto _ : state) {
+        with(b);
+    }
+}
+
+void bm_builder_none(benchmark::State &state) {
+    builder_benchmark(state, [](builder &b) { b.with_none(); });
+}
+
+void bm_builder_bool(benchmark::State &state) {
+    builder_benchmark(state, [](builder &b) { b.with_bool(true); });
+}
+
+void bm_builder_int(benchmark::State &state) {
+    builder_benchmark(state, [](builder &b) { b.with_int(-1234567890); });
+}
+
+void bm_builder_uint(benchmark::State &state) {
+    builder_benchmark(state, [](builder &b) { b.with_uint(12345678901234567890u); });
+}
+
+void bm_builder_float(benchmark::State &state) {
+    builder_benchmark(state, [](builder &b) { b.with_float(-65.613616999999977); });
+}
+
+void bm_builder_string(benchmark::State &state) {
+    builder_benchmark(state, [](builder &b) { b.with_string("the quick \"brown\" fox"); });
+}
+
+void bm_builder_mapping(benchmark::State &state) {
+    builder_benchmark(state, [](builder &b) { b.push_mapping().key("key").with_int(1).pop(); });
+}
+
+BENCHMARK(bm_builder_none)->ArgName("compact")->Arg(1)->Arg(0);
+BENCHMARK(bm_builder_bool)->ArgName("compact")->Arg(1)->Arg(0);
+BENCHMARK(bm_builder_int)->ArgName("compact")->Arg(1)->Arg(0);
+BENCHMARK(bm_builder_uint)->ArgName("compact")->Arg(1)->Arg(0);
+BENCHMARK(bm_builder_float)->ArgName("compact")->Arg(1)->Arg(0);
+BENCHMARK(bm_builder_string)->ArgName("compact")->Arg(1)->Arg(0);
+BENCHMARK(bm_builder_mapping)->ArgName("compact")->Arg(1)->Arg(0);
+
+// a mapping of state.range(0) members, each a sequence of a few scalars
+void bm_to_composite(benchmark::State &state) {
+    auto members = state.range(0);
+    std::string keys[] = {"alpha", "beta", "gamma", "delta"};
+
+    for (auto _ : state) {
+        to_composite v;
+        v.push_mapping();
+        for (int64_t i = 0; i < members; ++i) {
+            v.push_sequence(keys[i % 4] + std::to_string(i));
+            v.scalar(int64_t{i});
+            v.scalar(1.5);
+            v.scalar(std::string("value"));
+            v.scalar(none{});
+            v.pop();
+        }
+        v.pop();
+        benchmark::DoNotOptimize(v.collect());
+    }
+    state.SetItemsProcessed(state.iterations() * members * 5);
+}
+
+BENCHMARK(bm_to_composite)->ArgName("members")->Arg(16)->Arg(1024);
+
+}
+}
@@ -0,0 +1,228 @@
+#include "corpus.hh"
+#include <cstdint>
+#include <string_view>
+
+namespace kjson {
+namespace corpus {
+
+namespace {
+
+// splitmix64, so the output does not depend on the standard library
+class rng {
+  public:
+    explicit rng(uint64_t seed)
+      : d_state(seed) {
+    }
+
+    uint64_t next() {
+        uint64_t z = (d_state += 0x9e3779b97f4a7c15ULL);
+        z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z          = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    size_t below(size_t n) {
+        return next() % n;
+    }
+
+    template <size_t N>
+    std::string_view pick(const std::string_view (&items)[N]) {
+        return items[below(N)];
+    }
+
+  private:
+    uint64_t d_state;
+};
+
+constexpr std::string_view words[] = {
+    "the", "json", "parser", "stream", "café", "naïve", "日本語", "テスト", "данные", "😀",
+    "quote\\\"d", "tab\\t", "line\\nbreak", "\\u00e9t\\u00e9", "\\ud83d\\ude80", "latency", "p99", "gateway",
+};
+
+void sentence(rng& r, std::string& out, size_t n) {
+    for(size_t i = 0; i < n; ++i) {
+        if(i) {
+            out += ' ';
+        }
+        out += r.pick(words);
+    }
+}
+
+void decimal(rng& r, std::string& out, int whole, int digits) {
+    out += std::to_string(static_cast<int64_t>(r.below(2 * whole + 1)) - whole);
+    out += '.';
+    for(int i = 0; i < digits; ++i) {
+        out += static_cast<char>('0' + r.below(10));
+    }
+}
+
+std::string make_twitter() {
+    rng         r(1);
+    std::string out = R"({"statuses":[)";
+    for(int i = 0; i < 400; ++i) {
+        if(i) {
+            out += ',';
+        }
+        auto id = std::to_string(505874924095815681ULL + r.below(1ULL << 40));
+        out += R"({"id":)" + id + R"(,"id_str":")" + id + R"(","text":")";
+        sentence(r, out, 8 + r.below(16));
+        out += R"(","user":{"id":)" + std::to_string(r.below(1u << 31)) + R"(,"name":")";
+        sentence(r, out, 2);
+        out += R"(","screen_name":"user_)" + std::to_string(i) + R"(","description":")";
+        sentence(r, out, r.below(20));
+        out += R"(","followers_count":)" + std::to_string(r.below(100000));
+        out += R"(,"verified":)";
+        out += r.below(10) ? "false" : "true";
+        out += R"(,"url":null},"entities":{"hashtags":[)";
+        for(size_t j = 0, n = r.below(4); j < n; ++j) {
+            out += j ? "," : "";
+            out += R"({"text":")" + std::string(r.pick(words)) + R"(","indices":[)" + std::to_string(j * 10) + "," +
+                   std::to_string(j * 10 + 8) + "]}";
+        }
+        out += R"(],"urls":[]},"retweet_count":)" + std::to_string(r.below(5000));
+        out += R"(,"favorited":false,"lang":")";
+        out += r.below(2) ? "ja" : "en";
+        out += R"("})";
+    }
+    out += R"(],"search_metadata":{"count":400,"completed_in":0.087}})";
+    return out;
+}
+
+std::string make_geojson() {
+    rng         r(2);
+    std::string out = R"({"type":"FeatureCollection","features":[)";
+    for(int i = 0; i < 20; ++i) {
+        if(i) {
+            out += ',';
+        }
+        out += R"({"type":"Feature","properties":{"name":"region )" + std::to_string(i) +
+               R"("},"geometry":{"type":"Polygon","coordinates":[[)";
+        for(int j = 0; j < 1000; ++j) {
+            out += j ? ",[" : "[";
+            decimal(r, out, 180, 15);
+            out += ',';
+            decimal(r, out, 90, 15);
+            out += ']';
+        }
+        out += "]]}}";
+    }
+    out += "]}";
+    return out;
+}
+
+std::string make_deep() {
+    const int   depth = 1000;
+    std::string out;
+    for(int i = 0; i < depth; ++i) {
+        out += i % 2 ? R"({"level":)" + std::to_string(i) + R"(,"next":)" : "[1,";
+    }
+    out += "null";
+    for(int i = depth - 1; i >= 0; --i) {
+        out += i % 2 ? "}" : "]";
+    }
+    return out;
+}
+
+std::string make_long_strings() {
+    rng         r(3);
+    std::string out = "[";
+    for(int i = 0; i < 8; ++i) {
+        out += i ? ",\"" : "\"";
+        for(int j = 0; j < 40000; ++j) {
+            out += static_cast<char>('a' + r.below(26));
+            if(r.below(500) == 0) {
+                out += "\\n";
+            }
+        }
+        out += '"';
+    }
+    out += ']';
+    return out;
+}
+
+std::string make_flat_array() {
+    rng         r(4);
+    std::string out = "[";
+    for(int i = 0; i < 50000; ++i) {
+        if(i) {
+            out += ',';
+        }
+        if(r.below(2)) {
+            out += std::to_string(static_cast<int64_t>(r.next() >> r.below(64)) - (1LL << 20));
+        } else {
+            decimal(r, out, 1000, 6);
+        }
+    }
+    out += ']';
+    return out;
+}
+
+std::string make_wide_object() {
+    rng         r(5);
+    std::string out = "{";
+    for(int i = 0; i < 20000; ++i) {
+        if(i) {
+            out += ',';
+        }
+        out += "\"key_" + std::to_string(r.next() % 1000000007) + "_" + std::to_string(i) + "\":";
+        out += std::to_string(r.below(1000));
+    }
+    out += '}';
+    return out;
+}
+
+std::vector<std::string> make_ndjson() {
+    rng                      r(6);
+    std::vector<std::string> lines;
+    for(int i = 0; i < 5000; ++i) {
+        std::string line = R"({"ts":)" + std::to_string(1700000000000ULL + i * 17) + R"(,"level":")";
+        line += r.below(10) ? "info" : "error";
+        line += R"(","latency_ms":)";
+        decimal(r, line, 500, 3);
+        line += R"(,"msg":")";
+        sentence(r, line, 3 + r.below(8));
+        line += R"(","tags":["a","b"]})";
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+} // namespace
+
+const std::string& twitter() {
+    static const std::string data = make_twitter();
+    return data;
+}
+
+const std::string& geojson() {
+    static const std::string data = make_geojson();
+    return data;
+}
+
+const std::string& deep() {
+    static const std::string data = make_deep();
+    return data;
+}
+
+const std::string& long_strings() {
+    static const std::string data = make_long_strings();
+    return data;
+}
+
+const std::string& flat_array() {
+    static const std::string data = make_flat_array();
+    return data;
+}
+
+const std::string& wide_object() {
+    static const std::string data = make_wide_object();
+    return data;
+}
+
+const std::vector<std::string>& ndjson() {
+    static const std::vector<std::string> data = make_ndjson();
+    return data;
+}
+
+} // namespace corpus
+} // namespace kjson
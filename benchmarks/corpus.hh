@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace kjson {
+namespace corpus {
+
+// Generated documents of a few hundred KB each, identical on every run and
+// platform so results can be compared.
+
+// tweets: short strings, unicode, escapes and nested user objects
+const std::string& twitter();
+
+// polygon coordinates: mostly floating point numbers
+const std::string& geojson();
+
+// mappings and sequences nested a thousand levels deep
+const std::string& deep();
+
+// a few strings of tens of KB with sparse escapes
+const std::string& long_strings();
+
+// a single sequence of integers and floats
+const std::string& flat_array();
+
+// a single mapping with tens of thousands of members
+const std::string& wide_object();
+
+// small documents, one per line
+const std::vector<std::string>& ndjson();
+
+} // namespace corpus
+} // namespace kjson
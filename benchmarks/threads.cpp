@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include "corpus.hh"
+#include "json.hh"
+#include <algorithm>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace kjson {
+namespace {
+
+using namespace corpus;
+
+// parsed once and shared read-only by every thread
+const std::vector<document> &ndjson_documents() {
+    static const std::vector<document> docs = [] {
+        std::vector<document> result;
+        for (auto &line : ndjson()) {
+            result.push_back(load(line).expect("valid json"));
+        }
+        return result;
+    }();
+    return docs;
+}
+
+int max_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// items_per_second is the total over all threads, per_thread should stay flat
+// as long as the threads do not contend
+void report(benchmark::State &state, size_t documents) {
+    state.SetItemsProcessed(state.iterations() * documents);
+    state.counters["per_thread"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * documents),
+        benchmark::Counter::kIsRate | benchmark::Counter::kAvgThreads);
+}
+
+void bm_load_threads(benchmark::State &state) {
+    auto &lines = ndjson();
+
+    for (auto _ : state) {
+        for (auto &line : lines) {
+            benchmark::DoNotOptimize(load(line).expect("valid json"));
+        }
+    }
+    report(state, lines.size());
+}
+
+void bm_dump_threads(benchmark::State &state) {
+    auto &docs = ndjson_documents();
+    std::ofstream out("/dev/null");
+
+    for (auto _ : state) {
+        for (auto &doc : docs) {
+            dump(doc, out);
+        }
+    }
+    report(state, docs.size());
+}
+
+// both at the same time: every thread loads a document and dumps it again
+void bm_round_trip_threads(benchmark::State &state) {
+    auto &lines = ndjson();
+    std::ofstream out("/dev/null");
+
+    for (auto _ : state) {
+        for (auto &line : lines) {
+            dump(load(line).expect("valid json"), out);
+        }
+    }
+    report(state, lines.size());
+}
+
+BENCHMARK(bm_load_threads)->ThreadRange(1, max_threads())->UseRealTime();
+BENCHMARK(bm_dump_threads)->ThreadRange(1, max_threads())->UseRealTime();
+BENCHMARK(bm_round_trip_threads)->ThreadRange(1, max_threads())->UseRealTime();
+
+}
+}
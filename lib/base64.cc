@@ -0,0 +1,107 @@
+#include "base64.hh"
+#include <array>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+constexpr array<int8_t, 256> make_decode_table() {
+    array<int8_t, 256> table{};
+    for(size_t i = 0; i < table.size(); ++i) {
+        table[i] = -1;
+    }
+    for(int i = 0; i < 64; ++i) {
+        table[static_cast<unsigned char>(alphabet[i])] = i;
+    }
+    return table;
+}
+
+constexpr auto decode_table = make_decode_table();
+
+} // namespace
+
+void base64_encode(const byte* data, size_t size, char* out) {
+    auto at = [data](size_t i) { return static_cast<uint32_t>(data[i]); };
+
+    size_t i = 0;
+    for(; i + 3 <= size; i += 3) {
+        uint32_t v = at(i) << 16 | at(i + 1) << 8 | at(i + 2);
+        *out++     = alphabet[v >> 18];
+        *out++     = alphabet[(v >> 12) & 0x3f];
+        *out++     = alphabet[(v >> 6) & 0x3f];
+        *out++     = alphabet[v & 0x3f];
+    }
+
+    if(size - i == 1) {
+        uint32_t v = at(i) << 16;
+        *out++     = alphabet[v >> 18];
+        *out++     = alphabet[(v >> 12) & 0x3f];
+        *out++     = '=';
+        *out++     = '=';
+    } else if(size - i == 2) {
+        uint32_t v = at(i) << 16 | at(i + 1) << 8;
+        *out++     = alphabet[v >> 18];
+        *out++     = alphabet[(v >> 12) & 0x3f];
+        *out++     = alphabet[(v >> 6) & 0x3f];
+        *out++     = '=';
+    }
+}
+
+base64_decoder::base64_decoder(pmr::vector<byte>& out)
+  : d_out(out) {
+}
+
+bool base64_decoder::feed(char c) {
+    if(c == '=') {
+        // padding completes a group of two or three characters
+        if(d_count + d_padding < 2 || d_count + d_padding >= 4) {
+            return false;
+        }
+        ++d_padding;
+        return true;
+    }
+
+    auto v = decode_table[static_cast<unsigned char>(c)];
+    if(v < 0 || d_padding > 0) {
+        return false;
+    }
+
+    d_bits = d_bits << 6 | static_cast<uint32_t>(v);
+    if(++d_count == 4) {
+        d_out.push_back(static_cast<byte>(d_bits >> 16));
+        d_out.push_back(static_cast<byte>(d_bits >> 8));
+        d_out.push_back(static_cast<byte>(d_bits));
+        d_bits  = 0;
+        d_count = 0;
+    }
+    return true;
+}
+
+bool base64_decoder::finish() {
+    if(d_padding > 0 && d_count + d_padding != 4) {
+        return false;
+    }
+
+    switch(d_count) {
+    case 0:
+        return true;
+    case 2:
+        d_out.push_back(static_cast<byte>(d_bits >> 4));
+        break;
+    case 3:
+        d_out.push_back(static_cast<byte>(d_bits >> 10));
+        d_out.push_back(static_cast<byte>(d_bits >> 2));
+        break;
+    default:
+        return false;
+    }
+    d_bits  = 0;
+    d_count = 0;
+    return true;
+}
+
+} // namespace kjson
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace kjson {
+
+constexpr std::size_t base64_size(std::size_t n) {
+    return (n + 2) / 3 * 4;
+}
+
+// Writes base64_size(size) characters to out, padded with '='.
+void base64_encode(const std::byte* data, std::size_t size, char* out);
+
+// Decodes base64 one character at a time, so values can be decoded while they
+// are read.
+class base64_decoder {
+  public:
+    explicit base64_decoder(std::pmr::vector<std::byte>& out);
+
+    // returns false on a character that can not occur at this point
+    bool feed(char c);
+
+    // returns false if the input stopped in the middle of a group
+    bool finish();
+
+  private:
+    std::pmr::vector<std::byte>& d_out;
+    uint32_t                d_bits{0};
+    int                     d_count{0};
+    int                     d_padding{0};
+};
+
+} // namespace kjson
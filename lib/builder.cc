@@ -1,26 +1,98 @@
 #include "builder.hh"
+#include "base64.hh"
+#include "gather.hh"
+#include "instrument.hh"
+#include <algorithm>
 #include <cassert>
-#include <iomanip>
+#include <charconv>
 #include <limits>
+#include <memory_resource>
 #include <ostream>
 #include <stack>
+#include <variant>
+#include <vector>
 
 namespace kjson {
 
 using namespace std;
 
+namespace {
+
+class output {
+  public:
+    virtual ~output() = default;
+
+    virtual void write(string_view s) = 0;
+
+    // Writes bytes that are guaranteed to outlive the output, allowing
+    // implementations to reference them instead of copying.
+    virtual void write_ref(string_view s) {
+        write(s);
+    }
+
+    void put(char c) {
+        write(string_view(&c, 1));
+    }
+};
+
+class stream_output : public output {
+  public:
+    explicit stream_output(ostream& out)
+      : d_out(out) {
+    }
+
+    void write(string_view s) override {
+        record([&s](stats& st) { st.bytes += s.size(); });
+        d_out.write(s.data(), s.size());
+    }
+
+  private:
+    ostream& d_out;
+};
+
+class gather_output : public output {
+  public:
+    explicit gather_output(gather& out)
+      : d_out(out) {
+    }
+
+    void write(string_view s) override {
+        record([&s](stats& st) { st.bytes += s.size(); });
+        d_out.append(s);
+    }
+
+    void write_ref(string_view s) override {
+        record([&s](stats& st) { st.bytes += s.size(); });
+        d_out.reference(s);
+    }
+
+  private:
+    gather& d_out;
+};
+
+} // namespace
+
 class builder::impl {
   public:
-    impl(ostream& out, bool compact)
-      : d_out(out)
-      , d_compact(compact) {
+    impl(variant<stream_output, gather_output> out, bool compact, pmr::memory_resource* resource,
+         bool reference = false)
+      : d_output(move(out))
+      , d_out(std::visit([](auto& o) -> output* { return &o; }, d_output))
+      , d_compact(compact)
+      , d_reference(reference)
+      , d_stack(pmr::vector<char>(resource))
+      , d_resource(resource) {
+    }
+
+    pmr::memory_resource* resource() const {
+        return d_resource;
     }
 
     ~impl() {
         flush();
     }
 
-    void key(string_view key) {
+    void key(string_view key, bool escaped) {
         if(!d_expect_key) {
             throw builder_error("not expecting a key");
         }
@@ -29,36 +101,58 @@ class builder::impl {
         comma();
         newline();
 
-        d_out << quoted(key);
-        d_out << (d_compact ? ":" : ": ");
+        if(escaped) {
+            write_string(key);
+        } else {
+            quoted(key);
+        }
+        d_out->write(d_compact ? ":" : ": ");
         d_needscomma = false;
         d_expect_key = false;
     }
 
     void with_none() {
-        scalar("null");
+        scalar([this] { d_out->write("null"); });
     }
 
     void with_bool(bool v) {
-        d_out << boolalpha;
-        scalar(v);
+        scalar([this, v] { d_out->write(v ? "true" : "false"); });
     }
 
     void with_int(int64_t v) {
-        scalar(v);
+        scalar([this, v] { number(v); });
     }
 
     void with_uint(uint64_t v) {
-        scalar(v);
+        scalar([this, v] { number(v); });
     }
 
     void with_float(double v) {
-        d_out.precision(std::numeric_limits<double>::max_digits10);
-        scalar(v);
+        scalar([this, v] { number(v, chars_format::general, numeric_limits<double>::max_digits10); });
+    }
+
+    void with_number(std::string_view v) {
+        scalar([this, v] { d_out->write(v); });
     }
 
     void with_string(std::string_view v) {
-        scalar(quoted(v));
+        record([v](stats& s) { s.string_bytes += v.size(); });
+        scalar([this, v] { quoted(v); });
+    }
+
+    void with_binary(const byte* data, size_t size) {
+        scalar([this, data, size] {
+            constexpr size_t block = 3 * 1024;
+            char             buf[base64_size(block)];
+
+            d_out->put('"');
+            for(size_t i = 0; i < size; i += block) {
+                auto n = min(block, size - i);
+                base64_encode(data + i, n, buf);
+                d_out->write(string_view(buf, base64_size(n)));
+            }
+            d_out->put('"');
+        });
     }
 
     void push_mapping() {
@@ -80,7 +174,7 @@ class builder::impl {
         auto c = d_stack.top();
         d_stack.pop();
         newline();
-        d_out << c;
+        d_out->put(c);
 
         if(is_mapping()) {
             d_expect_key = true;
@@ -99,8 +193,8 @@ class builder::impl {
         return !d_stack.empty() && d_stack.top() == '}';
     }
 
-    template <typename T>
-    void scalar(const T& v) {
+    template <typename writer_t>
+    void scalar(writer_t&& write) {
         expect_value();
 
         comma();
@@ -108,7 +202,8 @@ class builder::impl {
             newline();
         }
 
-        d_out << v;
+        record([](stats& s) { ++s.nodes; });
+        write();
         d_needscomma = true;
 
         if(is_mapping()) {
@@ -134,50 +229,108 @@ class builder::impl {
 
         comma();
         if (needs_space) {
-            d_out << ' ';
+            d_out->put(' ');
         }
         if (needs_newline) {
             newline();
         }
-        d_out << b;
+        d_out->put(b);
         d_stack.push(e);
+        record([](stats& s) { ++s.nodes; });
+        record_depth(d_stack.size());
 
         d_needscomma = false;
     }
 
     void comma() {
         if(d_needscomma) {
-            d_out << ',';
+            d_out->put(',');
         }
     }
 
     void newline() {
         if(!d_compact) {
-            d_out << '\n';
+            d_out->put('\n');
             for(size_t i = 0; i < d_stack.size(); ++i) {
-                d_out << "  ";
+                d_out->write("  ");
             }
         }
     }
 
-    ostream& d_out;
-    bool     d_compact{true};
+    template <typename T, typename... format_t>
+    void number(T v, format_t... format) {
+        char buf[32];
+        auto r = to_chars(buf, buf + sizeof(buf), v, format...);
+        assert(r.ec == errc());
+        d_out->write(string_view(buf, r.ptr - buf));
+    }
+
+    // same escaping as std::quoted, writing the unescaped runs by reference
+    void quoted(string_view v) {
+        d_out->put('"');
+
+        string_view::size_type i = v.find_first_of("\"\\");
+        if(i != string_view::npos) {
+            record([](stats& s) { ++s.escaped_strings; });
+        }
+        for(; i != string_view::npos; i = v.find_first_of("\"\\")) {
+            write_string(v.substr(0, i));
+            d_out->put('\\');
+            d_out->put(v[i]);
+            v.remove_prefix(i + 1);
+        }
+        write_string(v);
+
+        d_out->put('"');
+    }
+
+    // strings are only referenced when the caller promised to keep them alive
+    void write_string(string_view s) {
+        if(d_reference) {
+            d_out->write_ref(s);
+        } else {
+            d_out->write(s);
+        }
+    }
+
+    variant<stream_output, gather_output> d_output;
+    output*                               d_out;
+    bool                                  d_compact{true};
+    bool                                  d_reference{false};
 
-    bool        d_needscomma{false};
-    bool        d_expect_key{false};
-    stack<char> d_stack;
+    bool                           d_needscomma{false};
+    bool                           d_expect_key{false};
+    stack<char, pmr::vector<char>> d_stack;
+    pmr::memory_resource*          d_resource;
 };
 
-builder::builder(ostream& out, bool compact)
-  : d_pimpl(make_unique<impl>(out, compact)) {
+builder::builder(ostream& out, bool compact, pmr::memory_resource* resource)
+  : d_pimpl(new(resource->allocate(sizeof(impl), alignof(impl))) impl(stream_output(out), compact, resource)) {
+}
+
+builder::builder(gather& out, bool compact, pmr::memory_resource* resource, gather_strings strings)
+  : d_pimpl(new(resource->allocate(sizeof(impl), alignof(impl)))
+                impl(gather_output(out), compact, resource, strings == gather_strings::e_reference)) {
 }
 
 builder::~builder() {
 }
 
+void builder::deleter::operator()(impl* p) const {
+    auto resource = p->resource();
+    p->~impl();
+    resource->deallocate(p, sizeof(impl), alignof(impl));
+}
+
 builder& builder::key(string_view k) {
     assert(d_pimpl);
-    d_pimpl->key(k);
+    d_pimpl->key(k, false);
+    return *this;
+}
+
+builder& builder::escaped_key(string_view k) {
+    assert(d_pimpl);
+    d_pimpl->key(k, true);
     return *this;
 }
 
@@ -211,12 +364,24 @@ builder& builder::with_float(double v) {
     return *this;
 }
 
+builder& builder::with_number(string_view v) {
+    assert(d_pimpl);
+    d_pimpl->with_number(v);
+    return *this;
+}
+
 builder& builder::with_string(string_view v) {
     assert(d_pimpl);
     d_pimpl->with_string(v);
     return *this;
 }
 
+builder& builder::with_binary(const byte* data, size_t size) {
+    assert(d_pimpl);
+    d_pimpl->with_binary(data, size);
+    return *this;
+}
+
 builder& builder::push_mapping() {
     assert(d_pimpl);
     d_pimpl->push_mapping();
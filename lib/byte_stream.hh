@@ -0,0 +1,201 @@
+#pragma once
+
+#include "counting_buffer.hh"
+#include "json.hh"
+#include "visitor.hh"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <results/option.hh>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace kjson {
+
+// Big endian helpers shared by the binary encodings.
+
+template <typename T>
+void put_be(std::string& out, T v) {
+    static_assert(std::is_unsigned_v<T>, "expected an unsigned type");
+
+    for(std::size_t i = sizeof(T); i > 0; --i) {
+        out += static_cast<char>(static_cast<uint8_t>(v >> (8 * (i - 1))));
+    }
+}
+
+// json has no NaN or infinity, so a document holding one could not be dumped
+inline double finite(double d) {
+    if(!std::isfinite(d)) {
+        throw std::invalid_argument("non-finite floats are not supported");
+    }
+    return d;
+}
+
+class byte_reader {
+  public:
+    explicit byte_reader(std::streambuf& input)
+      : d_buf(input) {
+    }
+
+    bool at_eof() {
+        return d_buf.sgetc() == std::char_traits<char>::eof();
+    }
+
+    uint8_t get() {
+        auto c = d_buf.sbumpc();
+        if(c == std::char_traits<char>::eof()) {
+            throw std::invalid_argument("unexpected end of input");
+        }
+        return static_cast<uint8_t>(c);
+    }
+
+    template <typename T>
+    T get_be() {
+        static_assert(std::is_unsigned_v<T>, "expected an unsigned type");
+
+        T v = 0;
+        for(std::size_t i = 0; i < sizeof(T); ++i) {
+            v = static_cast<T>((v << 8) | get());
+        }
+        return v;
+    }
+
+    // Appends n bytes; the target grows as data arrives so a bogus length can
+    // not trigger a huge allocation up front.
+    void read(std::string& into, uint64_t n) {
+        constexpr uint64_t block = 64 * 1024;
+
+        while(n > 0) {
+            auto size = static_cast<std::size_t>(n < block ? n : block);
+            auto pos  = into.size();
+            into.resize(pos + size);
+
+            if(d_buf.sgetn(&into[pos], static_cast<std::streamsize>(size)) != static_cast<std::streamsize>(size)) {
+                throw std::invalid_argument("unexpected end of input");
+            }
+            n -= size;
+        }
+    }
+
+  private:
+    std::streambuf& d_buf;
+};
+
+// The part of the binary readers that does not depend on the encoding.
+// Containers are tracked on d_stack rather than by recursion, so the nesting
+// depth is not limited by the call stack. reader_t provides value(key, initial
+// byte), and next(), which reads the next member of the innermost container or
+// closes it.
+template <typename reader_t, typename frame_t>
+class stack_reader {
+  public:
+    stack_reader(std::streambuf& input, visitor& v, limits const& l)
+      : d_input(input)
+      , d_visitor(v)
+      , d_limits(l) {
+    }
+
+    void parse() {
+        auto& self = static_cast<reader_t&>(*this);
+        self.value(maybe_key::none(), d_input.get());
+        while(!d_stack.empty()) {
+            self.next();
+        }
+        if(!d_input.at_eof()) {
+            throw std::invalid_argument("trailing data after the document");
+        }
+    }
+
+  protected:
+    using maybe_key = results::option<std::string_view>;
+
+    void scalar(const maybe_key& key, scalar_t v) {
+        key.match(
+            [this, &v](std::string_view k) { d_visitor.scalar(k, std::move(v)); },
+            [this, &v] { d_visitor.scalar(std::move(v)); });
+    }
+
+    void binary(const maybe_key& key, const std::string& v) {
+        auto data = reinterpret_cast<const std::byte*>(v.data());
+        key.match(
+            [this, data, &v](std::string_view k) { d_visitor.binary(k, data, v.size()); },
+            [this, data, &v] { d_visitor.binary(data, v.size()); });
+    }
+
+    void count_node() {
+        if(++d_nodes > d_limits.max_nodes) {
+            throw std::invalid_argument("document exceeds the maximum number of nodes");
+        }
+    }
+
+    // members is the declared size, 0 when it is not known up front
+    void open(const maybe_key& key, bool mapping, uint64_t members, frame_t f) {
+        if(d_stack.size() >= d_limits.max_depth) {
+            throw std::invalid_argument("document exceeds the maximum depth");
+        }
+        if(members > d_limits.max_members) {
+            throw std::invalid_argument("container exceeds the maximum number of members");
+        }
+
+        if(mapping) {
+            key.match(
+                [this](std::string_view k) { d_visitor.push_mapping(k); },
+                [this] { d_visitor.push_mapping(); });
+        } else {
+            key.match(
+                [this](std::string_view k) { d_visitor.push_sequence(k); },
+                [this] { d_visitor.push_sequence(); });
+        }
+        d_stack.push_back(f);
+    }
+
+    void close() {
+        d_stack.pop_back();
+        d_visitor.pop();
+    }
+
+    byte_reader          d_input;
+    visitor&             d_visitor;
+    limits const&        d_limits;
+    std::vector<frame_t> d_stack;
+    std::string          d_key;
+
+  private:
+    std::size_t d_nodes{0};
+};
+
+// Runs a reader_t(input, visitor, limits) to completion, ending the input at
+// max_size bytes the way the json parser does.
+template <typename reader_t>
+maybe_error decode(std::streambuf& input, visitor& v, limits const& l) {
+    try {
+        if(l.max_size == std::numeric_limits<std::size_t>::max()) {
+            reader_t(input, v, l).parse();
+            return maybe_error::ok(std::monostate{});
+        }
+
+        std::size_t     read = 0;
+        counting_buffer buf(input, read, l.max_size);
+        try {
+            reader_t(buf, v, l).parse();
+        } catch(const std::exception&) {
+            if(!buf.exceeded()) {
+                throw;
+            }
+        }
+        if(buf.exceeded()) {
+            return maybe_error::err("document exceeds the maximum size");
+        }
+        return maybe_error::ok(std::monostate{});
+    } catch(const std::exception& e) {
+        return maybe_error::err(e.what());
+    }
+}
+
+} // namespace kjson
@@ -0,0 +1,387 @@
+#include "cbor.hh"
+#include "byte_stream.hh"
+#include "parser.hh"
+#include "view_buffer.hh"
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+enum major_t : uint8_t {
+    e_unsigned = 0,
+    e_negative = 1,
+    e_bytes    = 2,
+    e_text     = 3,
+    e_array    = 4,
+    e_map      = 5,
+    e_tag      = 6,
+    e_simple   = 7,
+};
+
+constexpr uint8_t indefinite = 31;
+constexpr uint8_t stop       = 0xff;
+
+constexpr size_t flush_size = 64 * 1024;
+
+void put_head(string& out, major_t major, uint64_t arg) {
+    uint8_t m = major << 5;
+
+    if(arg < 24) {
+        out += static_cast<char>(m | arg);
+    } else if(arg <= numeric_limits<uint8_t>::max()) {
+        out += static_cast<char>(m | 24);
+        put_be(out, static_cast<uint8_t>(arg));
+    } else if(arg <= numeric_limits<uint16_t>::max()) {
+        out += static_cast<char>(m | 25);
+        put_be(out, static_cast<uint16_t>(arg));
+    } else if(arg <= numeric_limits<uint32_t>::max()) {
+        out += static_cast<char>(m | 26);
+        put_be(out, static_cast<uint32_t>(arg));
+    } else {
+        out += static_cast<char>(m | 27);
+        put_be(out, arg);
+    }
+}
+
+void put_string(string& out, major_t major, string_view s) {
+    put_head(out, major, s.size());
+    out.append(s.data(), s.size());
+}
+
+void put_scalar(string& out, const scalar_t& v) {
+    std::visit([&out](auto&& item) {
+        using T = decay_t<decltype(item)>;
+
+        if constexpr(is_same_v<T, none>) {
+            out += static_cast<char>(0xf6);
+        } else if constexpr(is_same_v<T, bool>) {
+            out += static_cast<char>(item ? 0xf5 : 0xf4);
+        } else if constexpr(is_same_v<T, int64_t>) {
+            if(item < 0) {
+                put_head(out, e_negative, ~static_cast<uint64_t>(item));
+            } else {
+                put_head(out, e_unsigned, static_cast<uint64_t>(item));
+            }
+        } else if constexpr(is_same_v<T, uint64_t>) {
+            put_head(out, e_unsigned, item);
+        } else if constexpr(is_same_v<T, double>) {
+            uint64_t bits;
+            memcpy(&bits, &item, sizeof(bits));
+            out += static_cast<char>(0xfb);
+            put_be(out, bits);
+        } else {
+            put_string(out, e_text, item);
+        }
+    },
+               v);
+}
+
+double half_to_double(uint16_t half) {
+    int    exp  = (half >> 10) & 0x1f;
+    int    mant = half & 0x3ff;
+    double val;
+
+    if(exp == 0) {
+        val = ldexp(mant, -24);
+    } else if(exp != 31) {
+        val = ldexp(mant + 1024, exp - 25);
+    } else {
+        val = mant == 0 ? numeric_limits<double>::infinity() : numeric_limits<double>::quiet_NaN();
+    }
+    return half & 0x8000 ? -val : val;
+}
+
+// remaining counts down a definite length, members counts up an open ended one
+struct cbor_frame {
+    bool     mapping;
+    bool     open_ended;
+    uint64_t remaining;
+    uint64_t members;
+};
+
+class cbor_reader : public stack_reader<cbor_reader, cbor_frame> {
+  public:
+    using stack_reader::stack_reader;
+
+  private:
+    friend class stack_reader<cbor_reader, cbor_frame>;
+
+    uint64_t argument(uint8_t info) {
+        switch(info) {
+        case 24:
+            return d_input.get();
+        case 25:
+            return d_input.get_be<uint16_t>();
+        case 26:
+            return d_input.get_be<uint32_t>();
+        case 27:
+            return d_input.get_be<uint64_t>();
+        default:
+            if(info < 24) {
+                return info;
+            }
+            throw invalid_argument("invalid cbor argument");
+        }
+    }
+
+    void read_chunk(string& into, uint64_t size) {
+        if(size > d_limits.max_string - into.size()) {
+            throw invalid_argument("string exceeds the maximum length");
+        }
+        d_input.read(into, size);
+    }
+
+    string string_value(uint8_t initial) {
+        major_t major = static_cast<major_t>(initial >> 5);
+        uint8_t info  = initial & 0x1f;
+
+        string result;
+        if(info != indefinite) {
+            read_chunk(result, argument(info));
+            return result;
+        }
+
+        uint8_t chunk;
+        while((chunk = d_input.get()) != stop) {
+            if(chunk >> 5 != major || (chunk & 0x1f) == indefinite) {
+                throw invalid_argument("invalid chunk in indefinite length string");
+            }
+            read_chunk(result, argument(chunk & 0x1f));
+        }
+        return result;
+    }
+
+    // reads the next member of the innermost container, or closes it
+    void next() {
+        auto&   f       = d_stack.back();
+        uint8_t initial = 0;
+        if(f.open_ended ? (initial = d_input.get()) == stop : f.remaining == 0) {
+            close();
+            return;
+        }
+        if(!f.open_ended) {
+            --f.remaining;
+            initial = d_input.get();
+        } else if(++f.members > d_limits.max_members) {
+            throw invalid_argument("container exceeds the maximum number of members");
+        }
+
+        if(!f.mapping) {
+            value(maybe_key::none(), initial);
+            return;
+        }
+        if(initial >> 5 != e_text) {
+            throw invalid_argument("only text keys are supported");
+        }
+        d_key = string_value(initial);
+        value(maybe_key::some(d_key), d_input.get());
+    }
+
+    void open(const maybe_key& key, bool mapping, uint8_t info) {
+        bool     open_ended = info == indefinite;
+        uint64_t n          = open_ended ? 0 : argument(info);
+        stack_reader::open(key, mapping, n, cbor_frame{mapping, open_ended, n, 0});
+    }
+
+    void value(const maybe_key& key, uint8_t initial) {
+        // tags are skipped in a loop, a long chain of them needs no stack
+        while(initial >> 5 == e_tag) {
+            argument(initial & 0x1f);
+            initial = d_input.get();
+        }
+
+        count_node();
+
+        major_t major = static_cast<major_t>(initial >> 5);
+        uint8_t info  = initial & 0x1f;
+
+        switch(major) {
+        case e_unsigned:
+            scalar(key, argument(info));
+            break;
+
+        case e_negative: {
+            auto n = argument(info);
+            if(n > static_cast<uint64_t>(numeric_limits<int64_t>::max())) {
+                throw out_of_range("negative integer out of range");
+            }
+            scalar(key, -static_cast<int64_t>(n) - 1);
+        } break;
+
+        case e_bytes:
+            binary(key, string_value(initial));
+            break;
+
+        case e_text:
+            scalar(key, string_value(initial));
+            break;
+
+        case e_array:
+        case e_map:
+            open(key, major == e_map, info);
+            break;
+
+        case e_tag: // skipped above
+            break;
+
+        case e_simple:
+            simple(key, info);
+            break;
+        }
+    }
+
+    void simple(const maybe_key& key, uint8_t info) {
+        switch(info) {
+        case 20:
+            scalar(key, false);
+            break;
+        case 21:
+            scalar(key, true);
+            break;
+        case 22:
+        case 23:
+            scalar(key, none{});
+            break;
+        case 25:
+            scalar(key, finite(half_to_double(d_input.get_be<uint16_t>())));
+            break;
+        case 26: {
+            auto  bits = d_input.get_be<uint32_t>();
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            scalar(key, finite(f));
+        } break;
+        case 27: {
+            auto   bits = d_input.get_be<uint64_t>();
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            scalar(key, finite(d));
+        } break;
+        default:
+            throw invalid_argument("unsupported cbor simple value");
+        }
+    }
+};
+
+} // namespace
+
+cbor_writer::cbor_writer(ostream& out)
+  : d_out(out) {
+}
+
+cbor_writer::~cbor_writer() {
+    flush();
+}
+
+void cbor_writer::scalar(scalar_t v) {
+    put_scalar(d_buffer, v);
+    written();
+}
+
+void cbor_writer::scalar(string_view key, scalar_t v) {
+    write_key(key);
+    scalar(move(v));
+}
+
+void cbor_writer::push_sequence() {
+    d_buffer += static_cast<char>(e_array << 5 | indefinite);
+    ++d_depth;
+}
+
+void cbor_writer::push_sequence(string_view key) {
+    write_key(key);
+    push_sequence();
+}
+
+void cbor_writer::push_mapping() {
+    d_buffer += static_cast<char>(e_map << 5 | indefinite);
+    ++d_depth;
+}
+
+void cbor_writer::push_mapping(string_view key) {
+    write_key(key);
+    push_mapping();
+}
+
+void cbor_writer::pop() {
+    d_buffer += static_cast<char>(stop);
+    --d_depth;
+    written();
+}
+
+void cbor_writer::flush() {
+    d_out.write(d_buffer.data(), d_buffer.size());
+    d_buffer.clear();
+}
+
+void cbor_writer::binary(const byte* data, size_t size) {
+    put_string(d_buffer, e_bytes, string_view(reinterpret_cast<const char*>(data), size));
+    written();
+}
+
+void cbor_writer::binary(string_view key, const byte* data, size_t size) {
+    write_key(key);
+    binary(data, size);
+}
+
+void cbor_writer::write_key(string_view key) {
+    put_string(d_buffer, e_text, key);
+}
+
+void cbor_writer::written() {
+    if(d_depth == 0 || d_buffer.size() >= flush_size) {
+        flush();
+    }
+}
+
+maybe_error load_cbor(istream& input, visitor& v) {
+    return load_cbor(input, v, limits{});
+}
+
+maybe_error load_cbor(string_view input, visitor& v) {
+    return load_cbor(input, v, limits{});
+}
+
+result load_cbor(istream& input) {
+    return load_cbor(input, limits{});
+}
+
+result load_cbor(string_view input) {
+    return load_cbor(input, limits{});
+}
+
+maybe_error load_cbor(istream& input, visitor& v, const limits& l) {
+    return decode<cbor_reader>(*input.rdbuf(), v, l);
+}
+
+maybe_error load_cbor(string_view input, visitor& v, const limits& l) {
+    view_buffer buf(input);
+    return decode<cbor_reader>(buf, v, l);
+}
+
+result load_cbor(istream& input, const limits& l) {
+    to_composite v;
+    return load_cbor(input, v, l)
+        .map([&v](auto) { return v.collect(); });
+}
+
+result load_cbor(string_view input, const limits& l) {
+    to_composite v;
+    return load_cbor(input, v, l)
+        .map([&v](auto) { return v.collect(); });
+}
+
+void dump_cbor(const document& data, ostream& out) {
+    cbor_writer w(out);
+    walk(data, w);
+}
+
+} // namespace kjson
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <streambuf>
+
+namespace kjson {
+
+// Reads through another stream buffer, counting the bytes. The input ends
+// after limit bytes; exceeded() then tells whether the source had more.
+class counting_buffer : public std::streambuf {
+  public:
+    counting_buffer(std::streambuf& source, std::size_t& count,
+                    std::size_t limit = std::numeric_limits<std::size_t>::max())
+      : d_source(source)
+      , d_count(count)
+      , d_left(limit) {
+    }
+
+    bool exceeded() const {
+        return d_exceeded;
+    }
+
+  protected:
+    int_type underflow() override {
+        if(d_left == 0) {
+            d_exceeded = d_source.sgetc() != traits_type::eof();
+            return traits_type::eof();
+        }
+
+        auto n = d_source.sgetn(d_buffer, static_cast<std::streamsize>(std::min(sizeof(d_buffer), d_left)));
+        if(n <= 0) {
+            return traits_type::eof();
+        }
+        d_count += n;
+        d_left -= n;
+        setg(d_buffer, d_buffer, d_buffer + n);
+        return traits_type::to_int_type(d_buffer[0]);
+    }
+
+  private:
+    std::streambuf& d_source;
+    std::size_t&    d_count;
+    std::size_t     d_left;
+    bool            d_exceeded{false};
+    char            d_buffer[4096];
+};
+
+// Writes through to another stream buffer, counting the bytes.
+class counting_output : public std::streambuf {
+  public:
+    counting_output(std::streambuf& target, std::size_t& count)
+      : d_target(target)
+      , d_count(count) {
+    }
+
+  protected:
+    int_type overflow(int_type c) override {
+        if(traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+        if(traits_type::eq_int_type(d_target.sputc(traits_type::to_char_type(c)), traits_type::eof())) {
+            return traits_type::eof();
+        }
+        ++d_count;
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        auto written = d_target.sputn(s, n);
+        d_count += written;
+        return written;
+    }
+
+    int sync() override {
+        return d_target.pubsync();
+    }
+
+  private:
+    std::streambuf& d_target;
+    std::size_t&    d_count;
+};
+
+} // namespace kjson
@@ -0,0 +1,328 @@
+#include "diff.hh"
+#include "parser.hh"
+#include "tree.hh"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+struct merkle::node {
+    tree::kind_t               kind{tree::e_scalar};
+    scalar_t                   value;
+    uint64_t                   hash{0};
+    vector<node>               items;
+    vector<pair<string, node>> members; // sorted by key
+};
+
+namespace {
+
+using node = merkle::node;
+
+uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t hash_bytes(uint64_t seed, const void* data, size_t size) {
+    auto     p = static_cast<const unsigned char*>(data);
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for(size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return mix(h);
+}
+
+enum tag_t : uint64_t {
+    e_none = 1,
+    e_bool,
+    e_integer,
+    e_unsigned,
+    e_float,
+    e_string,
+    e_sequence,
+    e_mapping,
+};
+
+uint64_t hash_integer(int64_t v) {
+    return hash_bytes(e_integer, &v, sizeof(v));
+}
+
+uint64_t hash_scalar(const scalar_t& v) {
+    return std::visit([](auto&& item) -> uint64_t {
+        using T = decay_t<decltype(item)>;
+
+        if constexpr(is_same_v<T, none>) {
+            return mix(e_none);
+        } else if constexpr(is_same_v<T, bool>) {
+            return mix(e_bool * 2 + item);
+        } else if constexpr(is_same_v<T, int64_t>) {
+            return hash_integer(item);
+        } else if constexpr(is_same_v<T, uint64_t>) {
+            if(item <= static_cast<uint64_t>(numeric_limits<int64_t>::max())) {
+                return hash_integer(static_cast<int64_t>(item));
+            }
+            return hash_bytes(e_unsigned, &item, sizeof(item));
+        } else if constexpr(is_same_v<T, double>) {
+            if(trunc(item) == item && item >= -9.2e18 && item <= 9.2e18) {
+                return hash_integer(static_cast<int64_t>(item));
+            }
+            return hash_bytes(e_float, &item, sizeof(item));
+        } else {
+            return hash_bytes(e_string, item.data(), item.size());
+        }
+    },
+                      v);
+}
+
+node hashed(tree&& t) {
+    node n;
+    n.kind = t.kind;
+    switch(t.kind) {
+    case tree::e_scalar:
+        n.hash  = hash_scalar(t.value);
+        n.value = move(t.value);
+        break;
+    case tree::e_sequence: {
+        uint64_t h = mix(e_sequence);
+        for(auto&& item : t.items) {
+            n.items.push_back(hashed(move(item)));
+            h = mix(h * 31 + n.items.back().hash);
+        }
+        n.hash = h;
+    } break;
+    case tree::e_mapping: {
+        // a sum keeps the hash independent of member order
+        uint64_t h = mix(e_mapping);
+        for(auto&& m : t.members) {
+            auto k = hash_bytes(e_string, m.first.data(), m.first.size());
+            n.members.emplace_back(move(m.first), hashed(move(m.second)));
+            h += mix(k ^ (n.members.back().second.hash * 0x9e3779b97f4a7c15ULL));
+        }
+        n.hash = h;
+        sort(n.members.begin(), n.members.end(), [](auto&& a, auto&& b) { return a.first < b.first; });
+    } break;
+    }
+    return n;
+}
+
+void replay(const node& n, visitor& v, const string_view* key) {
+    switch(n.kind) {
+    case tree::e_scalar:
+        if(key) {
+            v.scalar(*key, n.value);
+        } else {
+            v.scalar(n.value);
+        }
+        break;
+    case tree::e_sequence:
+        if(key) {
+            v.push_sequence(*key);
+        } else {
+            v.push_sequence();
+        }
+        for(auto&& item : n.items) {
+            replay(item, v, nullptr);
+        }
+        v.pop();
+        break;
+    case tree::e_mapping:
+        if(key) {
+            v.push_mapping(*key);
+        } else {
+            v.push_mapping();
+        }
+        for(auto&& m : n.members) {
+            string_view k = m.first;
+            replay(m.second, v, &k);
+        }
+        v.pop();
+        break;
+    }
+}
+
+// json pointer reference tokens escape '~' and '/'
+string pointer(const string& parent, string_view token) {
+    string result = parent + '/';
+    for(char c : token) {
+        if(c == '~') {
+            result += "~0";
+        } else if(c == '/') {
+            result += "~1";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+class json_patch {
+  public:
+    explicit json_patch(visitor& out)
+      : d_out(out) {
+    }
+
+    void diff(const string& path, const node& a, const node& b) {
+        if(a.hash == b.hash) {
+            return;
+        }
+
+        if(a.kind == tree::e_mapping && b.kind == tree::e_mapping) {
+            mappings(path, a, b);
+        } else if(a.kind == tree::e_sequence && b.kind == tree::e_sequence) {
+            sequences(path, a, b);
+        } else {
+            op("replace", path, &b);
+        }
+    }
+
+  private:
+    void mappings(const string& path, const node& a, const node& b) {
+        auto i = a.members.begin();
+        auto j = b.members.begin();
+        while(i != a.members.end() || j != b.members.end()) {
+            if(j == b.members.end() || (i != a.members.end() && i->first < j->first)) {
+                op("remove", pointer(path, i->first), nullptr);
+                ++i;
+            } else if(i == a.members.end() || j->first < i->first) {
+                op("add", pointer(path, j->first), &j->second);
+                ++j;
+            } else {
+                diff(pointer(path, i->first), i->second, j->second);
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    void sequences(const string& path, const node& a, const node& b) {
+        size_t na = a.items.size();
+        size_t nb = b.items.size();
+
+        size_t prefix = 0;
+        while(prefix < na && prefix < nb && a.items[prefix].hash == b.items[prefix].hash) {
+            ++prefix;
+        }
+        size_t suffix = 0;
+        while(suffix < na - prefix && suffix < nb - prefix &&
+              a.items[na - 1 - suffix].hash == b.items[nb - 1 - suffix].hash) {
+            ++suffix;
+        }
+
+        size_t la = na - prefix - suffix;
+        size_t lb = nb - prefix - suffix;
+        size_t m  = min(la, lb);
+        for(size_t i = 0; i < m; ++i) {
+            diff(pointer(path, to_string(prefix + i)), a.items[prefix + i], b.items[prefix + i]);
+        }
+        for(size_t i = la; i > m; --i) {
+            op("remove", pointer(path, to_string(prefix + i - 1)), nullptr);
+        }
+        for(size_t i = m; i < lb; ++i) {
+            op("add", pointer(path, to_string(prefix + i)), &b.items[prefix + i]);
+        }
+    }
+
+    void op(string_view name, const string& path, const node* value) {
+        d_out.push_mapping();
+        d_out.scalar("op", string(name));
+        d_out.scalar("path", path);
+        if(value) {
+            string_view key = "value";
+            replay(*value, d_out, &key);
+        }
+        d_out.pop();
+    }
+
+    visitor& d_out;
+};
+
+// b's value replaces a's unless both are mappings; removed members become null
+void merge_patch(const node& a, const node& b, visitor& out, const string_view* key) {
+    if(a.kind != tree::e_mapping || b.kind != tree::e_mapping) {
+        replay(b, out, key);
+        return;
+    }
+
+    if(key) {
+        out.push_mapping(*key);
+    } else {
+        out.push_mapping();
+    }
+
+    auto i = a.members.begin();
+    auto j = b.members.begin();
+    while(i != a.members.end() || j != b.members.end()) {
+        if(j == b.members.end() || (i != a.members.end() && i->first < j->first)) {
+            out.scalar(i->first, none{});
+            ++i;
+        } else if(i == a.members.end() || j->first < i->first) {
+            string_view k = j->first;
+            replay(j->second, out, &k);
+            ++j;
+        } else {
+            if(i->second.hash != j->second.hash) {
+                string_view k = i->first;
+                merge_patch(i->second, j->second, out, &k);
+            }
+            ++i;
+            ++j;
+        }
+    }
+    out.pop();
+}
+
+} // namespace
+
+merkle::merkle(const document& data) {
+    tree_builder b;
+    walk(data, b);
+    d_root = make_unique<node>(hashed(b.collect()));
+}
+
+merkle::merkle(merkle&&) noexcept = default;
+merkle& merkle::operator=(merkle&&) noexcept = default;
+merkle::~merkle()                            = default;
+
+uint64_t merkle::hash() const {
+    return d_root->hash;
+}
+
+uint64_t hash(const document& data) {
+    return merkle(data).hash();
+}
+
+void diff(const merkle& from, const merkle& to, visitor& out, patch_format format) {
+    if(format == patch_format::e_merge_patch) {
+        if(from.hash() == to.hash()) {
+            out.push_mapping();
+            out.pop();
+        } else {
+            merge_patch(*from.d_root, *to.d_root, out, nullptr);
+        }
+        return;
+    }
+
+    out.push_sequence();
+    json_patch(out).diff("", *from.d_root, *to.d_root);
+    out.pop();
+}
+
+document diff(const document& from, const document& to, patch_format format) {
+    to_composite v;
+    diff(merkle(from), merkle(to), v, format);
+    return v.collect();
+}
+
+} // namespace kjson
@@ -0,0 +1,116 @@
+#include "gather.hh"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+constexpr size_t chunk_size = 64 * 1024;
+
+#ifdef IOV_MAX
+constexpr size_t max_iov = IOV_MAX;
+#else
+constexpr size_t max_iov = 1024;
+#endif
+
+} // namespace
+
+gather::gather(size_t min_reference)
+  : d_min_reference(min_reference) {
+}
+
+void gather::append(string_view s) {
+    if(s.empty()) {
+        return;
+    }
+
+    char* dest = reserve(s.size());
+    memcpy(dest, s.data(), s.size());
+
+    if(!d_buffers.empty() &&
+       static_cast<char*>(d_buffers.back().iov_base) + d_buffers.back().iov_len == dest) {
+        d_buffers.back().iov_len += s.size();
+    } else {
+        d_buffers.push_back(iovec{dest, s.size()});
+    }
+    d_size += s.size();
+}
+
+void gather::reference(string_view s) {
+    if(s.size() < d_min_reference) {
+        append(s);
+        return;
+    }
+
+    d_buffers.push_back(iovec{const_cast<char*>(s.data()), s.size()});
+    d_size += s.size();
+}
+
+const vector<iovec>& gather::buffers() const {
+    return d_buffers;
+}
+
+size_t gather::size() const {
+    return d_size;
+}
+
+maybe_error gather::flush(int fd) {
+    iovec* first = d_buffers.data();
+    iovec* last  = first + d_buffers.size();
+
+    while(first != last) {
+        auto count   = min<size_t>(last - first, max_iov);
+        auto written = ::writev(fd, first, static_cast<int>(count));
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return results::make_err<std::monostate>(string("writev failed: ") + strerror(errno));
+        }
+
+        auto remaining = static_cast<size_t>(written);
+        while(first != last && remaining >= first->iov_len) {
+            remaining -= first->iov_len;
+            ++first;
+        }
+        if(remaining > 0) {
+            first->iov_base = static_cast<char*>(first->iov_base) + remaining;
+            first->iov_len -= remaining;
+        }
+    }
+
+    clear();
+    return maybe_error::ok(std::monostate{});
+}
+
+void gather::clear() {
+    d_buffers.clear();
+    d_size  = 0;
+    d_chunk = 0;
+    d_used  = 0;
+}
+
+char* gather::reserve(size_t n) {
+    while(d_chunk < d_chunks.size() && d_chunks[d_chunk].capacity - d_used < n) {
+        ++d_chunk;
+        d_used = 0;
+    }
+
+    if(d_chunk == d_chunks.size()) {
+        auto capacity = max(chunk_size, n);
+        d_chunks.push_back(chunk{unique_ptr<char[]>(new char[capacity]), capacity});
+    }
+
+    char* dest = d_chunks[d_chunk].data.get() + d_used;
+    d_used += n;
+    return dest;
+}
+
+} // namespace kjson
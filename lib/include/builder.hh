@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <iosfwd>
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <string_view>
 #include <type_traits>
@@ -10,18 +12,38 @@
 
 namespace kjson {
 
+class gather;
+
 class builder_error : public std::runtime_error {
   public:
     using std::runtime_error::runtime_error;
 };
 
+// How a builder writing to a gather treats the strings of key() and
+// with_string().
+enum class gather_strings {
+    e_copy,      // copied into the gather
+    e_reference, // runs of at least the gather's min_reference bytes are
+                 // referenced, so the strings must stay alive until the gather
+                 // is flushed or cleared
+};
+
 class builder {
   public:
-    explicit builder(std::ostream& out, bool compact = false);
+    // The builder's state and stack are allocated from resource, which must
+    // outlive it.
+    explicit builder(std::ostream& out, bool compact = false,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    explicit builder(gather& out, bool compact = false,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                     gather_strings strings                = gather_strings::e_copy);
     ~builder();
 
     builder& key(std::string_view k);
 
+    // k is written as is, it must be a quoted and escaped string
+    builder& escaped_key(std::string_view k);
+
     template <typename T>
     builder& value(T&& v);
 
@@ -31,6 +53,13 @@ class builder {
     builder& with_uint(uint64_t v);
     builder& with_float(double v);
     builder& with_string(std::string_view v);
+
+    // v is written as is, it must be a valid json number
+    builder& with_number(std::string_view v);
+
+    // writes the data as a base64 string
+    builder& with_binary(const std::byte* data, std::size_t size);
+
     builder& push_mapping();
     builder& push_sequence();
 
@@ -41,7 +70,11 @@ class builder {
   private:
     class impl;
 
-    std::unique_ptr<impl> d_pimpl;
+    struct deleter {
+        void operator()(impl* p) const;
+    };
+
+    std::unique_ptr<impl, deleter> d_pimpl;
 };
 
 template <typename T>
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "json.hh"
+#include "visitor.hh"
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kjson {
+
+// Encodes visitor events as CBOR (RFC 8949). Containers are written with
+// indefinite lengths so no buffering is needed.
+class cbor_writer : public visitor {
+  public:
+    explicit cbor_writer(std::ostream& out);
+    ~cbor_writer() override;
+
+    void scalar(scalar_t v) override;
+    void scalar(std::string_view key, scalar_t v) override;
+
+    void push_sequence() override;
+    void push_sequence(std::string_view key) override;
+
+    void push_mapping() override;
+    void push_mapping(std::string_view key) override;
+
+    void pop() override;
+
+    void binary(const std::byte* data, std::size_t size) override;
+    void binary(std::string_view key, const std::byte* data, std::size_t size) override;
+
+    void flush();
+
+  private:
+    void write_key(std::string_view key);
+    void written();
+
+    std::ostream& d_out;
+    std::string   d_buffer;
+    std::size_t   d_depth{0};
+};
+
+maybe_error load_cbor(std::istream& input, visitor& v);
+maybe_error load_cbor(std::string_view input, visitor& v);
+result      load_cbor(std::istream& input);
+result      load_cbor(std::string_view input);
+
+// Fail as soon as one of the limits is crossed, as json load() does.
+maybe_error load_cbor(std::istream& input, visitor& v, limits const& l);
+maybe_error load_cbor(std::string_view input, visitor& v, limits const& l);
+result      load_cbor(std::istream& input, limits const& l);
+result      load_cbor(std::string_view input, limits const& l);
+
+void dump_cbor(document const& data, std::ostream& out);
+
+} // namespace kjson
@@ -0,0 +1,598 @@
+#pragma once
+
+#include "builder.hh"
+#include "json.hh"
+#include "visitor.hh"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stack>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Describes the fields of a struct so it can be serialized without an
+// intermediate document, for example:
+//
+//   struct point { int x; int y; };
+//   KJSON_DESCRIBE(point, x, y)
+//
+// The macro must be used in the namespace of the described type, it supports up
+// to 32 fields. Described types can be written with dump() and read with
+// load_into().
+#define KJSON_DESCRIBE(type, ...)                                            \
+    [[maybe_unused]] constexpr auto kjson_fields(const type*) {              \
+        using kjson_described_t = type;                                      \
+        return std::make_tuple(KJSON_DESCRIBE_FOR_EACH(KJSON_FIELD, __VA_ARGS__)); \
+    }
+
+#define KJSON_FIELD(name) \
+    ::kjson::field<kjson_described_t, decltype(kjson_described_t::name)>{#name, "\"" #name "\"", &kjson_described_t::name}
+
+#define KJSON_DESCRIBE_EXPAND(x) x
+#define KJSON_DESCRIBE_EACH_1(m, x) m(x)
+#define KJSON_DESCRIBE_EACH_2(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_1(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_3(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_2(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_4(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_3(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_5(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_4(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_6(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_5(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_7(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_6(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_8(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_7(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_9(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_8(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_10(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_9(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_11(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_10(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_12(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_11(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_13(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_12(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_14(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_13(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_15(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_14(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_16(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_15(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_17(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_16(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_18(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_17(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_19(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_18(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_20(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_19(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_21(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_20(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_22(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_21(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_23(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_22(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_24(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_23(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_25(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_24(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_26(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_25(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_27(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_26(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_28(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_27(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_29(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_28(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_30(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_29(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_31(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_30(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_EACH_32(m, x, ...) m(x), KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_EACH_31(m, __VA_ARGS__))
+#define KJSON_DESCRIBE_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, name, ...) name
+#define KJSON_DESCRIBE_FOR_EACH(m, ...) \
+    KJSON_DESCRIBE_EXPAND(KJSON_DESCRIBE_SELECT(__VA_ARGS__, KJSON_DESCRIBE_EACH_32, KJSON_DESCRIBE_EACH_31, KJSON_DESCRIBE_EACH_30, KJSON_DESCRIBE_EACH_29, KJSON_DESCRIBE_EACH_28, KJSON_DESCRIBE_EACH_27, KJSON_DESCRIBE_EACH_26, KJSON_DESCRIBE_EACH_25, KJSON_DESCRIBE_EACH_24, KJSON_DESCRIBE_EACH_23, KJSON_DESCRIBE_EACH_22, KJSON_DESCRIBE_EACH_21, KJSON_DESCRIBE_EACH_20, KJSON_DESCRIBE_EACH_19, KJSON_DESCRIBE_EACH_18, KJSON_DESCRIBE_EACH_17, KJSON_DESCRIBE_EACH_16, KJSON_DESCRIBE_EACH_15, KJSON_DESCRIBE_EACH_14, KJSON_DESCRIBE_EACH_13, KJSON_DESCRIBE_EACH_12, KJSON_DESCRIBE_EACH_11, KJSON_DESCRIBE_EACH_10, KJSON_DESCRIBE_EACH_9, KJSON_DESCRIBE_EACH_8, KJSON_DESCRIBE_EACH_7, KJSON_DESCRIBE_EACH_6, KJSON_DESCRIBE_EACH_5, KJSON_DESCRIBE_EACH_4, KJSON_DESCRIBE_EACH_3, KJSON_DESCRIBE_EACH_2, KJSON_DESCRIBE_EACH_1)(m, __VA_ARGS__))
+
+namespace kjson {
+
+template <typename T, typename M>
+struct field {
+    using type        = T;
+    using member_type = M;
+
+    std::string_view name;
+    std::string_view escaped_name;
+    M T::*member;
+};
+
+namespace detail {
+
+template <typename T>
+constexpr bool dependent_false = false;
+
+template <typename T, typename = void>
+struct is_described : std::false_type {
+};
+
+template <typename T>
+struct is_described<T, std::void_t<decltype(kjson_fields(static_cast<const T*>(nullptr)))>> : std::true_type {
+};
+
+template <typename T>
+struct is_optional : std::false_type {
+};
+
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {
+};
+
+template <typename T>
+struct is_vector : std::false_type {
+};
+
+template <typename T, typename A>
+struct is_vector<std::vector<T, A>> : std::true_type {
+};
+
+template <typename T>
+struct is_map : std::false_type {
+};
+
+template <typename K, typename T, typename C, typename A>
+struct is_map<std::map<K, T, C, A>> : std::is_convertible<K, std::string_view> {
+};
+
+template <typename K, typename T, typename H, typename E, typename A>
+struct is_map<std::unordered_map<K, T, H, E, A>> : std::is_convertible<K, std::string_view> {
+};
+
+} // namespace detail
+
+template <typename T>
+constexpr bool is_described_v = detail::is_described<T>::value;
+
+template <typename T>
+constexpr auto fields_of() {
+    static_assert(is_described_v<T>, "type is not described, use KJSON_DESCRIBE");
+    return kjson_fields(static_cast<const T*>(nullptr));
+}
+
+namespace detail {
+
+constexpr uint64_t hash_name(std::string_view name, uint64_t seed) {
+    uint64_t h = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+    for(char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h ^ (h >> 32);
+}
+
+constexpr std::size_t hash_table_size(std::size_t n) {
+    std::size_t size = 1;
+    while(size < 4 * n) {
+        size *= 2;
+    }
+    return size;
+}
+
+// Collision free mapping from the N names of a described type to their index,
+// the seed is searched for at compile time.
+template <std::size_t N>
+struct perfect_hash {
+    static_assert(N < std::numeric_limits<uint8_t>::max(), "too many fields");
+
+    static constexpr std::size_t size = hash_table_size(N);
+
+    uint64_t                   seed{0};
+    std::array<uint8_t, size>  slots{};
+    std::array<std::string_view, N> names{};
+
+    constexpr std::size_t find(std::string_view name) const {
+        std::size_t i = slots[hash_name(name, seed) & (size - 1)];
+        return i < N && names[i] == name ? i : N;
+    }
+};
+
+template <std::size_t N>
+constexpr perfect_hash<N> make_perfect_hash(const std::array<std::string_view, N>& names) {
+    for(uint64_t seed = 0;; ++seed) {
+        perfect_hash<N> h{seed, {}, names};
+        for(auto& slot : h.slots) {
+            slot = N;
+        }
+
+        bool found = true;
+        for(std::size_t i = 0; found && i < N; ++i) {
+            auto& slot = h.slots[hash_name(names[i], seed) & (h.size - 1)];
+            found      = slot == N;
+            slot       = static_cast<uint8_t>(i);
+        }
+
+        if(found) {
+            return h;
+        }
+    }
+}
+
+template <typename T>
+struct field_index {
+    static constexpr auto        fields = fields_of<T>();
+    static constexpr std::size_t size   = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+    static constexpr auto        hash   = make_perfect_hash(std::apply([](auto&&... f) {
+        return std::array<std::string_view, size>{f.name...};
+    },
+                                                                   fields));
+};
+
+// Calls f with the member of obj that is named key, returns false if there is none.
+template <typename T, typename F, std::size_t... I>
+bool with_field(T& obj, std::string_view key, F& f, std::index_sequence<I...>) {
+    using handler = void (*)(T&, F&);
+
+    static constexpr handler table[] = {
+        [](T& o, F& fn) { fn(o.*(std::get<I>(field_index<T>::fields).member)); }...};
+
+    std::size_t i = field_index<T>::hash.find(key);
+    if(i == sizeof...(I)) {
+        return false;
+    }
+
+    table[i](obj, f);
+    return true;
+}
+
+template <typename T, typename F>
+bool with_field(T& obj, std::string_view key, F&& f) {
+    return with_field(obj, key, f, std::make_index_sequence<field_index<T>::size>{});
+}
+
+} // namespace detail
+
+template <typename T>
+void serialize(builder& b, const T& v);
+
+template <typename T, typename = std::enable_if_t<is_described_v<T>>>
+void dump(const T& data, std::ostream& out, bool compact = true) {
+    builder b(out, compact);
+    serialize(b, data);
+}
+
+template <typename T, typename = std::enable_if_t<is_described_v<T>>>
+void dump(const T& data, gather& out, bool compact = true) {
+    builder b(out, compact);
+    serialize(b, data);
+}
+
+template <typename T>
+void serialize(builder& b, const T& v) {
+    if constexpr(is_described_v<T>) {
+        b.push_mapping();
+        std::apply([&b, &v](auto&&... f) {
+            ((b.escaped_key(f.escaped_name), serialize(b, v.*(f.member))), ...);
+        },
+                   fields_of<T>());
+        b.pop();
+    } else if constexpr(detail::is_optional<T>::value) {
+        if(v) {
+            serialize(b, *v);
+        } else {
+            b.with_none();
+        }
+    } else if constexpr(detail::is_vector<T>::value) {
+        b.push_sequence();
+        for(auto&& item : v) {
+            serialize(b, item);
+        }
+        b.pop();
+    } else if constexpr(detail::is_map<T>::value) {
+        b.push_mapping();
+        for(auto&& kv : v) {
+            b.key(kv.first);
+            serialize(b, kv.second);
+        }
+        b.pop();
+    } else if constexpr(std::is_arithmetic_v<T> || std::is_convertible_v<T, std::string_view>) {
+        b.value(v);
+    } else {
+        static_assert(detail::dependent_false<T>, "type can not be serialized, describe it with KJSON_DESCRIBE");
+    }
+}
+
+namespace detail {
+
+class slot {
+  public:
+    virtual ~slot() = default;
+
+    virtual void scalar(scalar_t v)                       = 0;
+    virtual void scalar(std::string_view key, scalar_t v) = 0;
+
+    virtual std::unique_ptr<slot> push_sequence()                     = 0;
+    virtual std::unique_ptr<slot> push_sequence(std::string_view key) = 0;
+
+    virtual std::unique_ptr<slot> push_mapping()                     = 0;
+    virtual std::unique_ptr<slot> push_mapping(std::string_view key) = 0;
+};
+
+template <typename T>
+void assign(T& dest, scalar_t&& v);
+
+template <typename T>
+std::unique_ptr<slot> open_sequence(T& dest);
+
+template <typename T>
+std::unique_ptr<slot> open_mapping(T& dest);
+
+class element_slot : public slot {
+  public:
+    void scalar(std::string_view, scalar_t) override {
+        throw std::invalid_argument("unexpected key");
+    }
+
+    std::unique_ptr<slot> push_sequence(std::string_view) override {
+        throw std::invalid_argument("unexpected key");
+    }
+
+    std::unique_ptr<slot> push_mapping(std::string_view) override {
+        throw std::invalid_argument("unexpected key");
+    }
+};
+
+class member_slot : public slot {
+  public:
+    void scalar(scalar_t) override {
+        throw std::invalid_argument("expected a key");
+    }
+
+    std::unique_ptr<slot> push_sequence() override {
+        throw std::invalid_argument("expected a key");
+    }
+
+    std::unique_ptr<slot> push_mapping() override {
+        throw std::invalid_argument("expected a key");
+    }
+};
+
+class ignore_slot : public slot {
+  public:
+    void scalar(scalar_t) override {
+    }
+
+    void scalar(std::string_view, scalar_t) override {
+    }
+
+    std::unique_ptr<slot> push_sequence() override {
+        return std::make_unique<ignore_slot>();
+    }
+
+    std::unique_ptr<slot> push_sequence(std::string_view) override {
+        return std::make_unique<ignore_slot>();
+    }
+
+    std::unique_ptr<slot> push_mapping() override {
+        return std::make_unique<ignore_slot>();
+    }
+
+    std::unique_ptr<slot> push_mapping(std::string_view) override {
+        return std::make_unique<ignore_slot>();
+    }
+};
+
+template <typename T>
+class sequence_slot : public element_slot {
+  public:
+    explicit sequence_slot(T& dest)
+      : d_dest(dest) {
+        d_dest.clear();
+    }
+
+    void scalar(scalar_t v) override {
+        assign(d_dest.emplace_back(), std::move(v));
+    }
+
+    std::unique_ptr<slot> push_sequence() override {
+        return open_sequence(d_dest.emplace_back());
+    }
+
+    std::unique_ptr<slot> push_mapping() override {
+        return open_mapping(d_dest.emplace_back());
+    }
+
+  private:
+    T& d_dest;
+};
+
+template <typename T>
+class map_slot : public member_slot {
+  public:
+    explicit map_slot(T& dest)
+      : d_dest(dest) {
+        d_dest.clear();
+    }
+
+    void scalar(std::string_view key, scalar_t v) override {
+        assign(d_dest[typename T::key_type(key)], std::move(v));
+    }
+
+    std::unique_ptr<slot> push_sequence(std::string_view key) override {
+        return open_sequence(d_dest[typename T::key_type(key)]);
+    }
+
+    std::unique_ptr<slot> push_mapping(std::string_view key) override {
+        return open_mapping(d_dest[typename T::key_type(key)]);
+    }
+
+  private:
+    T& d_dest;
+};
+
+template <typename T>
+class struct_slot : public member_slot {
+  public:
+    explicit struct_slot(T& dest)
+      : d_dest(dest) {
+    }
+
+    void scalar(std::string_view key, scalar_t v) override {
+        with_field(d_dest, key, [&v](auto& member) { assign(member, std::move(v)); });
+    }
+
+    std::unique_ptr<slot> push_sequence(std::string_view key) override {
+        return open(key, [](auto& member) { return open_sequence(member); });
+    }
+
+    std::unique_ptr<slot> push_mapping(std::string_view key) override {
+        return open(key, [](auto& member) { return open_mapping(member); });
+    }
+
+  private:
+    template <typename F>
+    std::unique_ptr<slot> open(std::string_view key, F&& f) {
+        std::unique_ptr<slot> result;
+        if(!with_field(d_dest, key, [&result, &f](auto& member) { result = f(member); })) {
+            result = std::make_unique<ignore_slot>();
+        }
+        return result;
+    }
+
+    T& d_dest;
+};
+
+template <typename T, typename V>
+bool in_range(V v) {
+    if constexpr(std::is_signed_v<V>) {
+        if(v < 0) {
+            return std::is_signed_v<T> && static_cast<intmax_t>(v) >= static_cast<intmax_t>(std::numeric_limits<T>::min());
+        }
+    }
+    return static_cast<uintmax_t>(v) <= static_cast<uintmax_t>(std::numeric_limits<T>::max());
+}
+
+template <typename T, typename V>
+T convert_number(V v) {
+    if constexpr(std::is_floating_point_v<T>) {
+        return static_cast<T>(v);
+    } else if constexpr(std::is_floating_point_v<V>) {
+        throw std::invalid_argument("expected an integer");
+    } else {
+        if(!in_range<T>(v)) {
+            throw std::out_of_range("integer out of range");
+        }
+        return static_cast<T>(v);
+    }
+}
+
+template <typename T>
+constexpr bool is_value_v = std::is_arithmetic_v<T> || std::is_same_v<T, std::string> ||
+                            is_described_v<T> || is_vector<T>::value || is_map<T>::value;
+
+template <typename T>
+void assign(T& dest, scalar_t&& v) {
+    if constexpr(is_optional<T>::value) {
+        if(std::holds_alternative<none>(v)) {
+            dest.reset();
+        } else {
+            assign(dest.emplace(), std::move(v));
+        }
+    } else if constexpr(std::is_same_v<T, bool>) {
+        if(!std::holds_alternative<bool>(v)) {
+            throw std::invalid_argument("expected a boolean");
+        }
+        dest = std::get<bool>(v);
+    } else if constexpr(std::is_arithmetic_v<T>) {
+        std::visit([&dest](auto&& item) {
+            using V = std::decay_t<decltype(item)>;
+            if constexpr(std::is_arithmetic_v<V> && !std::is_same_v<V, bool>) {
+                dest = convert_number<T>(item);
+            } else {
+                throw std::invalid_argument("expected a number");
+            }
+        },
+                   v);
+    } else if constexpr(std::is_same_v<T, std::string>) {
+        if(!std::holds_alternative<std::string>(v)) {
+            throw std::invalid_argument("expected a string");
+        }
+        dest = std::move(std::get<std::string>(v));
+    } else if constexpr(is_value_v<T>) {
+        throw std::invalid_argument("unexpected scalar");
+    } else {
+        static_assert(dependent_false<T>, "type can not be deserialized, describe it with KJSON_DESCRIBE");
+    }
+}
+
+template <typename T>
+std::unique_ptr<slot> open_sequence(T& dest) {
+    if constexpr(is_optional<T>::value) {
+        return open_sequence(dest.emplace());
+    } else if constexpr(is_vector<T>::value) {
+        return std::make_unique<sequence_slot<T>>(dest);
+    } else if constexpr(is_value_v<T>) {
+        throw std::invalid_argument("unexpected sequence");
+    } else {
+        static_assert(dependent_false<T>, "type can not be deserialized, describe it with KJSON_DESCRIBE");
+    }
+}
+
+template <typename T>
+std::unique_ptr<slot> open_mapping(T& dest) {
+    if constexpr(is_optional<T>::value) {
+        return open_mapping(dest.emplace());
+    } else if constexpr(is_described_v<T>) {
+        return std::make_unique<struct_slot<T>>(dest);
+    } else if constexpr(is_map<T>::value) {
+        return std::make_unique<map_slot<T>>(dest);
+    } else if constexpr(is_value_v<T>) {
+        throw std::invalid_argument("unexpected mapping");
+    } else {
+        static_assert(dependent_false<T>, "type can not be deserialized, describe it with KJSON_DESCRIBE");
+    }
+}
+
+template <typename T>
+class into_visitor : public visitor {
+  public:
+    explicit into_visitor(T& dest)
+      : d_dest(dest) {
+    }
+
+    void scalar(scalar_t v) override {
+        if(d_stack.empty()) {
+            assign(d_dest, std::move(v));
+        } else {
+            d_stack.top()->scalar(std::move(v));
+        }
+    }
+
+    void scalar(std::string_view key, scalar_t v) override {
+        d_stack.top()->scalar(key, std::move(v));
+    }
+
+    void push_sequence() override {
+        d_stack.push(d_stack.empty() ? open_sequence(d_dest) : d_stack.top()->push_sequence());
+    }
+
+    void push_sequence(std::string_view key) override {
+        d_stack.push(d_stack.top()->push_sequence(key));
+    }
+
+    void push_mapping() override {
+        d_stack.push(d_stack.empty() ? open_mapping(d_dest) : d_stack.top()->push_mapping());
+    }
+
+    void push_mapping(std::string_view key) override {
+        d_stack.push(d_stack.top()->push_mapping(key));
+    }
+
+    void pop() override {
+        d_stack.pop();
+    }
+
+  private:
+    T&                                d_dest;
+    std::stack<std::unique_ptr<slot>> d_stack;
+};
+
+} // namespace detail
+
+// Parses input straight into a described type; members that are not in the
+// input keep their value, keys that are not members are skipped.
+template <typename T>
+maybe_error load_into(std::istream& input, T& dest) {
+    static_assert(is_described_v<T>, "type is not described, use KJSON_DESCRIBE");
+    detail::into_visitor<T> v(dest);
+    return load(input, v);
+}
+
+template <typename T>
+maybe_error load_into(std::string_view input, T& dest) {
+    static_assert(is_described_v<T>, "type is not described, use KJSON_DESCRIBE");
+    detail::into_visitor<T> v(dest);
+    return load(input, v);
+}
+
+} // namespace kjson
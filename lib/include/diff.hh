@@ -0,0 +1,43 @@
+#pragma once
+
+#include "json.hh"
+#include <cstdint>
+#include <memory>
+
+namespace kjson {
+
+class visitor;
+
+enum class patch_format {
+    e_json_patch,  // RFC 6902
+    e_merge_patch, // RFC 7386
+};
+
+// A copy of a document with a hash for every subtree. Mapping hashes do not
+// depend on member order and integral numbers hash the same whatever their
+// type. Keep one around to diff against repeatedly without rehashing.
+class merkle {
+  public:
+    explicit merkle(document const& data);
+    merkle(merkle&&) noexcept;
+    merkle& operator=(merkle&&) noexcept;
+    ~merkle();
+
+    uint64_t hash() const;
+
+    struct node;
+
+  private:
+    friend void diff(merkle const& from, merkle const& to, visitor& out, patch_format format);
+
+    std::unique_ptr<node> d_root;
+};
+
+uint64_t hash(document const& data);
+
+// Emits a patch that turns from into to; subtrees with equal hashes are
+// skipped without being compared.
+void     diff(merkle const& from, merkle const& to, visitor& out, patch_format format = patch_format::e_json_patch);
+document diff(document const& from, document const& to, patch_format format = patch_format::e_json_patch);
+
+} // namespace kjson
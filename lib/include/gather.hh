@@ -0,0 +1,52 @@
+#pragma once
+
+#include "json.hh"
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
+
+namespace kjson {
+
+// Collects output as a list of iovecs. Copied bytes are stored in chunks owned
+// by the gather; referenced bytes are not copied and must stay alive until the
+// gather is flushed or cleared.
+class gather {
+  public:
+    explicit gather(std::size_t min_reference = 256);
+
+    gather(const gather&) = delete;
+    gather& operator=(const gather&) = delete;
+
+    void append(std::string_view s);
+
+    // References s in place if it is at least min_reference bytes, copies it otherwise.
+    void reference(std::string_view s);
+
+    const std::vector<iovec>& buffers() const;
+
+    std::size_t size() const;
+
+    maybe_error flush(int fd);
+
+    void clear();
+
+  private:
+    struct chunk {
+        std::unique_ptr<char[]> data;
+        std::size_t             capacity;
+    };
+
+    char* reserve(std::size_t n);
+
+    std::size_t        d_min_reference;
+    std::vector<iovec> d_buffers;
+    std::size_t        d_size{0};
+
+    std::vector<chunk> d_chunks;
+    std::size_t        d_chunk{0};
+    std::size_t        d_used{0};
+};
+
+} // namespace kjson
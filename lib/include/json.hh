@@ -1,9 +1,13 @@
 #pragma once
 
 #include <composite/composite.hh>
+#include <cstddef>
 #include <iosfwd>
+#include <limits>
+#include <memory_resource>
 #include <results/option.hh>
 #include <results/result.hh>
+#include <string>
 #include <string_view>
 
 namespace kjson {
@@ -13,12 +17,64 @@ using result      = results::result<document>;
 using maybe_error = results::result<std::monostate>;
 
 class visitor;
+class gather;
 
 result      load(std::istream& input);
 result      load(std::string_view input);
 maybe_error load(std::istream& input, visitor& v);
 maybe_error load(std::string_view input, visitor& v);
 
+// Bounds checked while parsing; a load fails as soon as one is crossed, before
+// the input can use more stack, memory or time.
+struct limits {
+    std::size_t max_depth{std::numeric_limits<std::size_t>::max()};
+    std::size_t max_size{std::numeric_limits<std::size_t>::max()};    // bytes of input
+    std::size_t max_string{std::numeric_limits<std::size_t>::max()};  // bytes of a string, key or number
+    std::size_t max_members{std::numeric_limits<std::size_t>::max()}; // of a mapping or sequence
+    std::size_t max_nodes{std::numeric_limits<std::size_t>::max()};
+};
+
+result      load(std::istream& input, limits const& l);
+result      load(std::string_view input, limits const& l);
+maybe_error load(std::istream& input, visitor& v, limits const& l);
+maybe_error load(std::string_view input, visitor& v, limits const& l);
+
+// Replays a document as visitor events.
+void walk(document const& data, visitor& v);
+
 void dump(document const& data, std::ostream& out, bool compact = true);
 
+// Serializes the children of a top-level sequence or mapping concurrently; a
+// concurrency of 0 uses all hardware threads.
+void dump(document const& data, std::ostream& out, bool compact, std::size_t concurrency);
+
+// Allocates the writer's state from resource instead of the global heap.
+void dump(document const& data, std::ostream& out, std::pmr::memory_resource* resource, bool compact = true);
+
+// Gathers the output without copying large string values; data must outlive the
+// gather until it is flushed.
+void dump(document const& data, gather& out, bool compact = true);
+
+// Rewrite the whitespace between tokens without building a document; numbers
+// and strings are copied through byte for byte.
+maybe_error minify(std::istream& input, std::ostream& out);
+maybe_error minify(std::string_view input, std::ostream& out);
+maybe_error prettify(std::istream& input, std::ostream& out, std::size_t indent = 2);
+maybe_error prettify(std::string_view input, std::ostream& out, std::size_t indent = 2);
+
+struct validation {
+    bool        ok;
+    std::size_t offset; // of the first error
+    std::string error;
+
+    explicit operator bool() const {
+        return ok;
+    }
+};
+
+// Checks that the input is well-formed JSON in valid UTF-8 without decoding any
+// values.
+validation validate(std::string_view input);
+validation validate(std::istream& input);
+
 } // namespace kjson
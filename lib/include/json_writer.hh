@@ -0,0 +1,38 @@
+#pragma once
+
+#include "builder.hh"
+#include "visitor.hh"
+#include <iosfwd>
+#include <memory_resource>
+
+namespace kjson {
+
+// Writes visitor events as json, for example to convert other encodings.
+class json_writer : public visitor {
+  public:
+    explicit json_writer(std::ostream& out, bool compact = true,
+                         std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void scalar(scalar_t v) override;
+    void scalar(std::string_view key, scalar_t v) override;
+
+    void push_sequence() override;
+    void push_sequence(std::string_view key) override;
+
+    void push_mapping() override;
+    void push_mapping(std::string_view key) override;
+
+    void pop() override;
+
+    // valid numbers are copied byte for byte
+    void number(raw_number n) override;
+    void number(std::string_view key, raw_number n) override;
+
+    void binary(const std::byte* data, std::size_t size) override;
+    void binary(std::string_view key, const std::byte* data, std::size_t size) override;
+
+  private:
+    builder d_builder;
+};
+
+} // namespace kjson
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "json.hh"
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace kjson {
+
+// An open addressing hash table over the keys of a loaded mapping, for O(1)
+// lookups in mappings too large to search. The index points into the mapping,
+// which must outlive it and not change.
+//
+// The table is built by the first find() unless build() is called first; a
+// lazily built index must not be shared between threads.
+class key_index {
+  public:
+    explicit key_index(composite::mapping const& m);
+
+    void build() const;
+
+    // null when the mapping has no such key
+    document const* find(std::string_view key) const;
+
+    std::size_t size() const;
+
+    // bytes allocated by the index, not counting the mapping
+    std::size_t memory_usage() const;
+
+  private:
+    struct slot {
+        std::string_view key;
+        document const*  value{nullptr};
+    };
+
+    composite::mapping const& d_mapping;
+    mutable std::vector<slot> d_slots;
+    mutable std::size_t       d_size{0};
+};
+
+// A loaded document with an index over every mapping of at least min_keys
+// keys, built as part of the load.
+class indexed_document {
+  public:
+    document const& root() const;
+
+    // null when the mapping was too small to be indexed
+    key_index const* index(composite::mapping const& m) const;
+
+    std::size_t memory_usage() const;
+
+  private:
+    friend results::result<indexed_document> load_indexed(std::istream& input, std::size_t min_keys);
+
+    std::unique_ptr<document>                                 d_root;
+    std::unordered_map<composite::mapping const*, key_index> d_indexes;
+};
+
+results::result<indexed_document> load_indexed(std::istream& input, std::size_t min_keys = 1024);
+results::result<indexed_document> load_indexed(std::string_view input, std::size_t min_keys = 1024);
+
+} // namespace kjson
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "json.hh"
+#include "visitor.hh"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kjson {
+
+// Encodes visitor events as MessagePack. Container lengths are not known up
+// front, so containers are written with 32 bit lengths that are patched when
+// they are popped; output is written when the top-level value is complete.
+class msgpack_writer : public visitor {
+  public:
+    explicit msgpack_writer(std::ostream& out);
+
+    void scalar(scalar_t v) override;
+    void scalar(std::string_view key, scalar_t v) override;
+
+    void push_sequence() override;
+    void push_sequence(std::string_view key) override;
+
+    void push_mapping() override;
+    void push_mapping(std::string_view key) override;
+
+    void pop() override;
+
+    void binary(const std::byte* data, std::size_t size) override;
+    void binary(std::string_view key, const std::byte* data, std::size_t size) override;
+
+  private:
+    struct container {
+        std::size_t offset;
+        uint32_t    count;
+    };
+
+    void write_key(std::string_view key);
+    void push(uint8_t marker);
+    void written();
+
+    std::ostream&          d_out;
+    std::string            d_buffer;
+    std::vector<container> d_stack;
+};
+
+maybe_error load_msgpack(std::istream& input, visitor& v);
+maybe_error load_msgpack(std::string_view input, visitor& v);
+result      load_msgpack(std::istream& input);
+result      load_msgpack(std::string_view input);
+
+// Fail as soon as one of the limits is crossed, as json load() does.
+maybe_error load_msgpack(std::istream& input, visitor& v, limits const& l);
+maybe_error load_msgpack(std::string_view input, visitor& v, limits const& l);
+result      load_msgpack(std::istream& input, limits const& l);
+result      load_msgpack(std::string_view input, limits const& l);
+
+void dump_msgpack(document const& data, std::ostream& out);
+
+} // namespace kjson
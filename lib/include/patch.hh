@@ -0,0 +1,26 @@
+#pragma once
+
+#include "diff.hh"
+#include "json.hh"
+#include <iosfwd>
+
+namespace kjson {
+
+// Applies a patch while copying the input to out in one pass. Values the patch
+// does not touch are copied as raw bytes, minus insignificant whitespace,
+// without being decoded or checked.
+//
+// JSON Patch supports add, remove and replace; move, copy and test need other
+// parts of the document and are rejected, as are operations inside a value
+// added by an earlier operation of the same patch.
+//
+// out is written as the input is read, so when an error is returned it already
+// holds a truncated document, for example up to the end of the input when a
+// removed path turns out not to exist. Write to a temporary and keep it only on
+// success if out must stay valid.
+maybe_error apply_patch(std::istream& input, document const& patch, std::ostream& out,
+                        patch_format format = patch_format::e_json_patch);
+maybe_error apply_patch(std::string_view input, document const& patch, std::ostream& out,
+                        patch_format format = patch_format::e_json_patch);
+
+} // namespace kjson
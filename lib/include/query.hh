@@ -0,0 +1,71 @@
+#pragma once
+
+#include "json.hh"
+#include "visitor.hh"
+#include <iosfwd>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+namespace kjson {
+
+class query_error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+// A jq subset: paths (.a.b, .["a b"], .[0], .[]), pipes, select() with
+// comparisons joined by and/or, and object construction ({a, b: .c.d}).
+//
+// The leading path is matched while the input streams by. Matches are written
+// out directly when nothing follows the path, otherwise each match is buffered
+// on its own to evaluate the rest of the query.
+class query {
+  public:
+    static results::result<query> compile(std::string_view expression);
+
+    query(query&&) noexcept;
+    query& operator=(query&&) noexcept;
+    ~query();
+
+  private:
+    friend class query_visitor;
+
+    struct program;
+
+    query();
+
+    std::unique_ptr<program> d_program;
+};
+
+// Evaluates a query over visitor events and writes each result as a line of
+// json.
+class query_visitor : public visitor {
+  public:
+    query_visitor(const query& q, std::ostream& out, bool compact = true);
+    ~query_visitor() override;
+
+    void scalar(scalar_t v) override;
+    void scalar(std::string_view key, scalar_t v) override;
+
+    void number(raw_number n) override;
+    void number(std::string_view key, raw_number n) override;
+
+    void push_sequence() override;
+    void push_sequence(std::string_view key) override;
+
+    void push_mapping() override;
+    void push_mapping(std::string_view key) override;
+
+    void pop() override;
+
+  private:
+    class impl;
+
+    std::unique_ptr<impl> d_pimpl;
+};
+
+maybe_error filter(std::istream& input, const query& q, std::ostream& out, bool compact = true);
+maybe_error filter(std::string_view input, const query& q, std::ostream& out, bool compact = true);
+
+} // namespace kjson
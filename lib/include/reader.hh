@@ -0,0 +1,42 @@
+#pragma once
+
+#include "json.hh"
+#include <iosfwd>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+
+namespace kjson {
+
+class visitor;
+
+// Parses documents like load() but keeps its token, key and container stack
+// buffers between calls, so once they have grown to the largest document seen,
+// parsing into a visitor does not allocate beyond the values handed to it. Not
+// safe to share between threads; keep one per thread.
+//
+// Strings reach the visitor as std::string, so each string value longer than
+// the small string buffer still costs one allocation per load; keys do not.
+//
+// The buffers are allocated from resource, which must outlive the reader.
+// Documents returned by load() are built by composite and use the global heap.
+class reader {
+  public:
+    explicit reader(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    explicit reader(limits const& l, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    reader(reader&&) noexcept;
+    reader& operator=(reader&&) noexcept;
+    ~reader();
+
+    result      load(std::istream& input);
+    result      load(std::string_view input);
+    maybe_error load(std::istream& input, visitor& v);
+    maybe_error load(std::string_view input, visitor& v);
+
+  private:
+    class impl;
+
+    std::unique_ptr<impl> d_pimpl;
+};
+
+} // namespace kjson
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "json.hh"
+#include "visitor.hh"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kjson {
+
+class schema_error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+// A JSON Schema compiled to a table of nodes. Supported keywords are type,
+// enum, required, properties, items, minimum, maximum, exclusiveMinimum,
+// exclusiveMaximum, minLength, maxLength, minItems and maxItems; other keywords
+// are ignored.
+class schema {
+  public:
+    static results::result<schema> compile(document const& definition);
+    static results::result<schema> parse(std::string_view definition);
+
+  private:
+    friend class schema_validator;
+    friend class schema_compiler;
+
+    static constexpr std::size_t any = static_cast<std::size_t>(-1);
+
+    enum type_t : uint8_t {
+        e_null    = 1 << 0,
+        e_boolean = 1 << 1,
+        e_integer = 1 << 2,
+        e_number  = 1 << 3,
+        e_string  = 1 << 4,
+        e_array   = 1 << 5,
+        e_object  = 1 << 6,
+        e_all     = 0x7f,
+    };
+
+    struct property {
+        std::string name;
+        std::size_t node;
+        bool        required;
+    };
+
+    struct node {
+        uint8_t                    types{e_all};
+        std::optional<double>      minimum;
+        std::optional<double>      maximum;
+        std::optional<double>      exclusive_minimum;
+        std::optional<double>      exclusive_maximum;
+        std::optional<std::size_t> min_length;
+        std::optional<std::size_t> max_length;
+        std::optional<std::size_t> min_items;
+        std::optional<std::size_t> max_items;
+        std::vector<scalar_t>      enumeration;
+        bool                       has_enum{false};
+        std::vector<property>      properties; // sorted by name
+        std::size_t                required{0};
+        std::size_t                items{any};
+    };
+
+    std::vector<node> d_nodes;
+};
+
+// Checks visitor events against a schema and forwards them to the next visitor,
+// if any. The first violation throws a schema_error, which stops a parse.
+class schema_validator : public visitor {
+  public:
+    explicit schema_validator(const schema& s);
+    schema_validator(const schema& s, visitor& next);
+
+    void scalar(scalar_t v) override;
+    void scalar(std::string_view key, scalar_t v) override;
+
+    void push_sequence() override;
+    void push_sequence(std::string_view key) override;
+
+    void push_mapping() override;
+    void push_mapping(std::string_view key) override;
+
+    void pop() override;
+
+    // checked by value, forwarded as the source text
+    void number(raw_number n) override;
+    void number(std::string_view key, raw_number n) override;
+
+    bool expect_binary() override;
+    bool expect_binary(std::string_view key) override;
+
+    // checked as a string of the decoded bytes
+    void binary(const std::byte* data, std::size_t size) override;
+    void binary(std::string_view key, const std::byte* data, std::size_t size) override;
+
+  private:
+    // The place of a container in its parent is kept as a key in d_keys or an
+    // index, and only turned into text for an error.
+    struct frame {
+        std::size_t       node;
+        bool              mapping;
+        std::size_t       count;
+        std::size_t       required;
+        std::vector<bool> seen;
+        std::size_t       key_begin; // in d_keys
+        std::size_t       key_size;
+        std::size_t       index; // npos without one
+    };
+
+    std::size_t       enter(const std::string_view* key);
+    void              check_scalar(std::size_t node, const scalar_t& v);
+    void              push(std::size_t node, bool mapping);
+    std::string       segment() const;
+    std::string       segment(const frame& f) const;
+    [[noreturn]] void fail(const std::string& what, bool in_container = false) const;
+
+    const schema&           d_schema;
+    visitor*                d_next;
+    std::vector<frame>      d_stack;
+    std::string             d_keys;
+    const std::string_view* d_key{nullptr};
+};
+
+maybe_error validate(std::istream& input, const schema& s);
+maybe_error validate(std::string_view input, const schema& s);
+
+} // namespace kjson
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "json.hh"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace kjson {
+
+class visitor;
+
+class snapshot_error : public std::runtime_error {
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+// A document saved with save_snapshot() and mapped into memory. Values are read
+// in place: sequences and mappings are arrays of fixed size nodes, mapping keys
+// are sorted so lookups are a binary search, and strings live in a shared pool.
+class snapshot {
+  public:
+    // Refers to the snapshot object it came from, not to the mapping: a value,
+    // and the strings it returns, are only valid while that object lives and
+    // has not been moved from or assigned to. Take a new root() after a move.
+    class value {
+      public:
+        enum class type_t {
+            e_none,
+            e_bool,
+            e_int,
+            e_uint,
+            e_float,
+            e_string,
+            e_sequence,
+            e_mapping,
+        };
+
+        type_t type() const;
+
+        bool             as_bool() const;
+        int64_t          as_int() const;
+        uint64_t         as_uint() const;
+        double           as_float() const;
+        std::string_view as_string() const;
+
+        // number of items of a sequence or mapping
+        std::size_t size() const;
+
+        // the i-th item of a sequence, or the value of the i-th member of a mapping
+        value operator[](std::size_t i) const;
+
+        // the key of the i-th member of a mapping
+        std::string_view key(std::size_t i) const;
+
+        std::optional<value> find(std::string_view key) const;
+
+        void     walk(visitor& v) const;
+        document to_document() const;
+
+      private:
+        friend class snapshot;
+
+        value(const snapshot& owner, uint64_t offset);
+
+        void expect(type_t t) const;
+        void walk(visitor& v, const std::string_view* key) const;
+
+        const snapshot* d_owner;
+        uint64_t        d_offset;
+    };
+
+    snapshot(snapshot&& other) noexcept;
+    snapshot& operator=(snapshot&& other) noexcept;
+    ~snapshot();
+
+    value root() const;
+
+  private:
+    friend results::result<snapshot> open_snapshot(const std::string& path);
+
+    snapshot(const char* data, std::size_t size);
+
+    const char* at(uint64_t offset, uint64_t size) const;
+
+    const char* d_data{nullptr};
+    std::size_t d_size{0};
+    uint64_t    d_pool{0};
+    uint64_t    d_pool_size{0};
+};
+
+// Replaces path atomically: snapshots already open on it keep the old content,
+// and path is left as it was when saving fails.
+maybe_error save_snapshot(document const& data, const std::string& path);
+
+results::result<snapshot> open_snapshot(const std::string& path);
+
+} // namespace kjson
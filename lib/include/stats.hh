@@ -0,0 +1,50 @@
+#pragma once
+
+#include "json.hh"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string_view>
+
+namespace kjson {
+
+// Counters for a single load() or dump() call. They are only collected when
+// kjson is built with KJSON_STATS; otherwise the instrumentation is compiled
+// out and the counters stay zero.
+//
+// Allocations are counted by replacing the global operator new, so they include
+// those made by the visitor or composite on the calling thread. The replacement
+// is not part of libkjson: a program links the kjson_allocations objects to
+// count them, otherwise the counters stay zero.
+struct stats {
+#ifdef KJSON_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    std::size_t bytes{0}; // read by load, written by dump
+
+    std::array<std::size_t, 14> tokens{}; // indexed by token::type_t
+
+    std::size_t max_depth{0};
+    std::size_t nodes{0};
+    std::size_t string_bytes{0}; // decoded, including keys
+    std::size_t escaped_strings{0};
+
+    std::size_t allocations{0};
+    std::size_t allocated_bytes{0};
+
+    std::chrono::nanoseconds tokenize{0};
+    std::chrono::nanoseconds build{0}; // the visitor or document, or writing for dump
+};
+
+result      load(std::istream& input, stats& s);
+result      load(std::string_view input, stats& s);
+maybe_error load(std::istream& input, visitor& v, stats& s);
+maybe_error load(std::string_view input, visitor& v, stats& s);
+
+void dump(document const& data, std::ostream& out, stats& s, bool compact = true);
+
+} // namespace kjson
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "json.hh"
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string_view>
+
+namespace kjson {
+
+enum class trace_phase {
+    e_parse,     // a whole load, bytes of input
+    e_tokenize,  // every token of a load, bytes of their values
+    e_build,     // every value a load adds to a document, bytes of their strings
+    e_serialize, // a whole dump, bytes of output
+};
+
+// Receives the spans of the loads and dumps on the threads it is installed on.
+// e_tokenize and e_build run in many short pieces during a load; they are
+// summed and reported as one span each, nested in e_parse just before it ends.
+// Their begin and end come back to back, so every end carries the time the
+// phase took.
+//
+// The input bytes of e_parse are only known for stream buffers that can tell
+// their position, otherwise they are 0.
+class tracer {
+  public:
+    virtual ~tracer() = default;
+
+    virtual void begin(trace_phase phase)                                                = 0;
+    virtual void end(trace_phase phase, std::size_t bytes, std::chrono::nanoseconds elapsed) = 0;
+};
+
+// Installs a tracer on the calling thread until the scope ends, restoring the
+// previous one. Without a tracer every span is a thread local load and a branch.
+class trace_scope {
+  public:
+    explicit trace_scope(tracer& t);
+    ~trace_scope();
+
+    trace_scope(const trace_scope&)            = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+  private:
+    tracer* d_previous;
+};
+
+// Traced by t for this call only.
+result      load(std::istream& input, tracer& t);
+result      load(std::string_view input, tracer& t);
+maybe_error load(std::istream& input, visitor& v, tracer& t);
+maybe_error load(std::string_view input, visitor& v, tracer& t);
+
+void dump(document const& data, std::ostream& out, tracer& t, bool compact = true);
+
+} // namespace kjson
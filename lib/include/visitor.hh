@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -18,6 +19,22 @@ using scalar_t = std::variant<
     double,
     std::string>;
 
+// The source text of a number, converted only when asked for.
+struct raw_number {
+    std::string_view text;
+
+    // follows the json grammar, so the text can be written out as is
+    bool valid() const;
+
+    int64_t  as_int() const;
+    uint64_t as_uint() const;
+    double   as_float() const;
+
+    // an int64_t for negative integers, an uint64_t for other integers and a
+    // double otherwise
+    scalar_t value() const;
+};
+
 class visitor {
   public:
     virtual ~visitor() = default;
@@ -32,6 +49,36 @@ class visitor {
     virtual void push_mapping(std::string_view key) = 0;
 
     virtual void pop() = 0;
+
+    // Numbers are passed as their source text, which is only valid for the
+    // duration of the call; by default they are converted for scalar().
+    virtual void number(raw_number n) {
+        scalar(n.value());
+    }
+
+    virtual void number(std::string_view key, raw_number n) {
+        scalar(key, n.value());
+    }
+
+    // Asked before a string value is read. Returning true makes the parser
+    // decode it from base64 and deliver the bytes through binary() instead.
+    virtual bool expect_binary() {
+        return false;
+    }
+
+    virtual bool expect_binary(std::string_view) {
+        return false;
+    }
+
+    // Also called for byte strings of binary encodings; the data is only valid
+    // for the duration of the call.
+    virtual void binary(const std::byte* data, std::size_t size) {
+        scalar(std::string(reinterpret_cast<const char*>(data), size));
+    }
+
+    virtual void binary(std::string_view key, const std::byte* data, std::size_t size) {
+        scalar(key, std::string(reinterpret_cast<const char*>(data), size));
+    }
 };
 
 } // namespace kjson
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "stats.hh"
+#include "trace.hh"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace kjson {
+
+// The stats of the call in progress on this thread, if it asked for them.
+extern thread_local stats* t_stats;
+
+// Calls f with the current stats; compiled out without KJSON_STATS.
+template <typename F>
+inline void record(F&& f) {
+    if constexpr(stats::enabled) {
+        if(t_stats) {
+            f(*t_stats);
+        }
+    }
+}
+
+inline void record_depth(std::size_t depth) {
+    record([depth](stats& s) { s.max_depth = std::max(s.max_depth, depth); });
+}
+
+// Adds the time until it goes out of scope to a phase.
+class phase_timer {
+  public:
+    explicit phase_timer(std::chrono::nanoseconds stats::*phase)
+      : d_phase(phase) {
+        if constexpr(stats::enabled) {
+            if(t_stats) {
+                d_start = std::chrono::steady_clock::now();
+            }
+        }
+    }
+
+    ~phase_timer() {
+        record([this](stats& s) { s.*d_phase += std::chrono::steady_clock::now() - d_start; });
+    }
+
+  private:
+    std::chrono::nanoseconds stats::*d_phase;
+    std::chrono::steady_clock::time_point d_start;
+};
+
+// The tracer installed on this thread, if any.
+extern thread_local tracer* t_tracer;
+
+class trace_span;
+
+// The innermost span in progress on this thread, if a tracer is installed.
+extern thread_local trace_span* t_span;
+
+// A span of a phase until it goes out of scope, when a tracer is installed.
+// The trace_parts run inside it are reported as one span per phase before it
+// ends.
+class trace_span {
+  public:
+    explicit trace_span(trace_phase phase)
+      : d_tracer(t_tracer)
+      , d_phase(phase) {
+        if(d_tracer) {
+            d_outer = t_span;
+            t_span  = this;
+            d_tracer->begin(phase);
+            d_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~trace_span() {
+        if(!d_tracer) {
+            return;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - d_start;
+        t_span       = d_outer;
+        for(std::size_t i = 0; i < d_parts.size(); ++i) {
+            auto& p = d_parts[i];
+            if(p.ran) {
+                d_tracer->begin(static_cast<trace_phase>(i));
+                d_tracer->end(static_cast<trace_phase>(i), p.bytes, p.elapsed);
+            }
+        }
+        d_tracer->end(d_phase, d_bytes, elapsed);
+    }
+
+    trace_span(const trace_span&)            = delete;
+    trace_span& operator=(const trace_span&) = delete;
+
+    bool active() const {
+        return d_tracer != nullptr;
+    }
+
+    void bytes(std::size_t n) {
+        d_bytes = n;
+    }
+
+    void add(trace_phase phase, std::chrono::nanoseconds elapsed, std::size_t bytes) {
+        auto& p = d_parts[static_cast<std::size_t>(phase)];
+        p.elapsed += elapsed;
+        p.bytes += bytes;
+        p.ran = true;
+    }
+
+  private:
+    struct part {
+        std::chrono::nanoseconds elapsed{0};
+        std::size_t              bytes{0};
+        bool                     ran{false};
+    };
+
+    tracer*                               d_tracer;
+    trace_phase                           d_phase;
+    std::size_t                           d_bytes{0};
+    trace_span*                           d_outer{nullptr};
+    std::chrono::steady_clock::time_point d_start;
+    std::array<part, 4>                   d_parts{};
+};
+
+// Adds the time until it goes out of scope, and its bytes, to a phase of the
+// span in progress, as phase_timer does for stats.
+class trace_part {
+  public:
+    explicit trace_part(trace_phase phase)
+      : d_span(t_span)
+      , d_phase(phase) {
+        if(d_span) {
+            d_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~trace_part() {
+        if(d_span) {
+            d_span->add(d_phase, std::chrono::steady_clock::now() - d_start, d_bytes);
+        }
+    }
+
+    trace_part(const trace_part&)            = delete;
+    trace_part& operator=(const trace_part&) = delete;
+
+    void bytes(std::size_t n) {
+        d_bytes = n;
+    }
+
+  private:
+    trace_span*                           d_span;
+    trace_phase                           d_phase;
+    std::size_t                           d_bytes{0};
+    std::chrono::steady_clock::time_point d_start;
+};
+
+} // namespace kjson
@@ -1,14 +1,113 @@
 #include "json.hh"
+#include "counting_buffer.hh"
+#include "gather.hh"
+#include "instrument.hh"
 #include "json_builder.hh"
+#include "parallel_dump.hh"
 #include "parser.hh"
+#include "view_buffer.hh"
 #include <composite/builder.hh>
-#include <sstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 
 namespace kjson {
 
 using namespace std;
 
+namespace {
+
+class walker {
+  public:
+    explicit walker(visitor& v)
+      : d_visitor(v) {
+    }
+
+    template <typename T>
+    void operator()(T&& v) {
+        using U = decay_t<T>;
+
+        if constexpr(is_void_v<U> || is_empty_v<U>) {
+            scalar(none{});
+        } else if constexpr(is_same_v<U, bool>) {
+            scalar(v);
+        } else if constexpr(is_integral_v<U> && is_signed_v<U>) {
+            scalar(static_cast<int64_t>(v));
+        } else if constexpr(is_integral_v<U> && is_unsigned_v<U>) {
+            scalar(static_cast<uint64_t>(v));
+        } else if constexpr(is_floating_point_v<U>) {
+            scalar(static_cast<double>(v));
+        } else if constexpr(is_convertible_v<U, string_view>) {
+            scalar(string(string_view(v)));
+        } else {
+            throw invalid_argument("no conversion available");
+        }
+    }
+
+    void operator()(const composite::sequence& v) {
+        if(d_key) {
+            d_visitor.push_sequence(*d_key);
+        } else {
+            d_visitor.push_sequence();
+        }
+
+        for(auto&& item : v) {
+            d_key = nullptr;
+            item.visit(*this);
+        }
+        d_visitor.pop();
+    }
+
+    void operator()(const composite::mapping& v) {
+        if(d_key) {
+            d_visitor.push_mapping(*d_key);
+        } else {
+            d_visitor.push_mapping();
+        }
+
+        for(auto&& kv : v) {
+            string_view key = kv.first;
+            d_key           = &key;
+            kv.second.visit(*this);
+        }
+        d_visitor.pop();
+    }
+
+  private:
+    void scalar(scalar_t v) {
+        if(d_key) {
+            d_visitor.scalar(*d_key, move(v));
+        } else {
+            d_visitor.scalar(move(v));
+        }
+    }
+
+    visitor&           d_visitor;
+    const string_view* d_key{nullptr};
+};
+
+// Runs write in a serialize span; the output is only counted when a tracer is
+// installed.
+template <typename F>
+void serialize(ostream& out, F&& write) {
+    trace_span span(trace_phase::e_serialize);
+    if(!span.active()) {
+        write(out);
+        return;
+    }
+
+    size_t          written = 0;
+    counting_output buf(*out.rdbuf(), written);
+    ostream         str(&buf);
+    write(str);
+    out.setstate(str.rdstate());
+    span.bytes(written);
+}
+
+} // namespace
+
 result load(istream& input) {
     to_composite v;
     return load(input, v)
@@ -16,8 +115,9 @@ result load(istream& input) {
 }
 
 result load(string_view input) {
-    istringstream str{string{input}};
-    return load(str);
+    to_composite v;
+    return load(input, v)
+        .map([&v](auto) { return v.collect(); });
 }
 
 maybe_error load(istream& input, visitor& v) {
@@ -26,13 +126,66 @@ maybe_error load(istream& input, visitor& v) {
 }
 
 maybe_error load(string_view input, visitor& v) {
-    istringstream str{string{input}};
-    return load(str, v);
+    view_buffer buf(input);
+    return parse(buf, v)
+        .map([](auto&) { return std::monostate{}; });
+}
+
+result load(istream& input, const limits& l) {
+    to_composite v;
+    return load(input, v, l)
+        .map([&v](auto) { return v.collect(); });
+}
+
+result load(string_view input, const limits& l) {
+    to_composite v;
+    return load(input, v, l)
+        .map([&v](auto) { return v.collect(); });
+}
+
+maybe_error load(istream& input, visitor& v, const limits& l) {
+    parse_buffers buffers;
+    return parse(input, v, buffers, l);
+}
+
+maybe_error load(string_view input, visitor& v, const limits& l) {
+    view_buffer   buf(input);
+    parse_buffers buffers;
+    return parse(buf, v, buffers, l);
+}
+
+void walk(const document& data, visitor& v) {
+    walker w(v);
+    data.visit(w);
 }
 
 void dump(const document& data, ostream& out, bool compact) {
-    json_builder jb(out, compact);
-    data.visit(jb);
+    serialize(out, [&](ostream& o) {
+        json_builder jb(o, compact);
+        data.visit(jb);
+    });
+}
+
+void dump(const document& data, ostream& out, bool compact, size_t concurrency) {
+    serialize(out, [&](ostream& o) { parallel_dump(data, o, compact, concurrency); });
+}
+
+void dump(const document& data, ostream& out, pmr::memory_resource* resource, bool compact) {
+    serialize(out, [&](ostream& o) {
+        builder      b(o, compact, resource);
+        json_builder jb(b);
+        data.visit(jb);
+    });
+}
+
+void dump(const document& data, gather& out, bool compact) {
+    trace_span span(trace_phase::e_serialize);
+    auto       before = out.size();
+    {
+        json_builder jb(out, compact);
+        data.visit(jb);
+    }
+    span.bytes(out.size() - before);
 }
 
 } // namespace kjson
@@ -10,7 +10,17 @@ namespace {
 } // namespace
 
 json_builder::json_builder(std::ostream& out, bool compact)
-  : d_base(out, compact) {
+  : d_owned(std::in_place, out, compact)
+  , d_base(*d_owned) {
+}
+
+json_builder::json_builder(gather& out, bool compact)
+  : d_owned(std::in_place, out, compact, std::pmr::get_default_resource(), gather_strings::e_reference)
+  , d_base(*d_owned) {
+}
+
+json_builder::json_builder(builder& base)
+  : d_base(base) {
 }
 
 void json_builder::operator()(const composite::sequence& v) {
@@ -3,6 +3,7 @@
 #include "builder.hh"
 #include <composite/composite.hh>
 #include <iosfwd>
+#include <optional>
 #include <stack>
 
 namespace kjson {
@@ -10,6 +11,9 @@ namespace kjson {
 class json_builder {
   public:
     explicit json_builder(std::ostream& out, bool compact = false);
+    // strings of the document are referenced, it must outlive the gather's flush
+    explicit json_builder(gather& out, bool compact = false);
+    explicit json_builder(builder& base);
 
     template <typename T>
     void operator()(T&& v);
@@ -19,7 +23,8 @@ class json_builder {
     void operator()(const composite::mapping& v);
 
   private:
-    builder d_base;
+    std::optional<builder> d_owned;
+    builder&               d_base;
 };
 
 template <typename T>
@@ -0,0 +1,62 @@
+#include "json_writer.hh"
+#include <utility>
+
+namespace kjson {
+
+using namespace std;
+
+json_writer::json_writer(ostream& out, bool compact, pmr::memory_resource* resource)
+  : d_builder(out, compact, resource) {
+}
+
+void json_writer::scalar(scalar_t v) {
+    std::visit([this](auto&& item) { d_builder.value(item); }, v);
+}
+
+void json_writer::scalar(string_view key, scalar_t v) {
+    d_builder.key(key);
+    scalar(move(v));
+}
+
+void json_writer::push_sequence() {
+    d_builder.push_sequence();
+}
+
+void json_writer::push_sequence(string_view key) {
+    d_builder.key(key).push_sequence();
+}
+
+void json_writer::push_mapping() {
+    d_builder.push_mapping();
+}
+
+void json_writer::push_mapping(string_view key) {
+    d_builder.key(key).push_mapping();
+}
+
+void json_writer::pop() {
+    d_builder.pop();
+}
+
+void json_writer::number(raw_number n) {
+    if(n.valid()) {
+        d_builder.with_number(n.text);
+    } else {
+        scalar(n.value());
+    }
+}
+
+void json_writer::number(string_view key, raw_number n) {
+    d_builder.key(key);
+    number(n);
+}
+
+void json_writer::binary(const byte* data, size_t size) {
+    d_builder.with_binary(data, size);
+}
+
+void json_writer::binary(string_view key, const byte* data, size_t size) {
+    d_builder.key(key).with_binary(data, size);
+}
+
+} // namespace kjson
@@ -0,0 +1,152 @@
+#include "key_index.hh"
+#include "parser.hh"
+#include "view_buffer.hh"
+#include <functional>
+#include <istream>
+#include <utility>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+size_t hash_key(string_view key) {
+    return std::hash<string_view>{}(key);
+}
+
+// collects the mappings with at least min_keys keys
+class collector {
+  public:
+    explicit collector(size_t min_keys)
+      : d_min_keys(min_keys) {
+    }
+
+    template <typename T>
+    void operator()(T&&) {
+    }
+
+    void operator()(const composite::sequence& v) {
+        for(auto&& item : v) {
+            item.visit(*this);
+        }
+    }
+
+    void operator()(const composite::mapping& v) {
+        size_t n = 0;
+        for(auto&& kv : v) {
+            kv.second.visit(*this);
+            ++n;
+        }
+        if(n >= d_min_keys) {
+            d_found.push_back(&v);
+        }
+    }
+
+    vector<const composite::mapping*> d_found;
+
+  private:
+    size_t d_min_keys;
+};
+
+} // namespace
+
+key_index::key_index(const composite::mapping& m)
+  : d_mapping(m) {
+}
+
+void key_index::build() const {
+    if(!d_slots.empty()) {
+        return;
+    }
+
+    size_t n = 0;
+    for(auto&& kv : d_mapping) {
+        (void)kv;
+        ++n;
+    }
+
+    // a power of two at most three quarters full
+    size_t capacity = 4;
+    while(capacity * 3 < n * 4) {
+        capacity *= 2;
+    }
+    d_slots.resize(capacity);
+
+    size_t mask = capacity - 1;
+    for(auto&& kv : d_mapping) {
+        string_view key = kv.first;
+        for(size_t i = hash_key(key) & mask;; i = (i + 1) & mask) {
+            if(!d_slots[i].value) {
+                d_slots[i] = slot{key, &kv.second};
+                break;
+            }
+        }
+    }
+    d_size = n;
+}
+
+const document* key_index::find(string_view key) const {
+    build();
+
+    size_t mask = d_slots.size() - 1;
+    for(size_t i = hash_key(key) & mask; d_slots[i].value; i = (i + 1) & mask) {
+        if(d_slots[i].key == key) {
+            return d_slots[i].value;
+        }
+    }
+    return nullptr;
+}
+
+size_t key_index::size() const {
+    build();
+    return d_size;
+}
+
+size_t key_index::memory_usage() const {
+    return d_slots.capacity() * sizeof(slot);
+}
+
+const document& indexed_document::root() const {
+    return *d_root;
+}
+
+const key_index* indexed_document::index(const composite::mapping& m) const {
+    auto it = d_indexes.find(&m);
+    return it == d_indexes.end() ? nullptr : &it->second;
+}
+
+size_t indexed_document::memory_usage() const {
+    size_t bytes = d_indexes.bucket_count() * sizeof(void*) +
+                   d_indexes.size() * (sizeof(void*) + sizeof(decltype(d_indexes)::value_type));
+    for(auto&& i : d_indexes) {
+        bytes += i.second.memory_usage();
+    }
+    return bytes;
+}
+
+results::result<indexed_document> load_indexed(istream& input, size_t min_keys) {
+    to_composite v;
+    auto         parsed = parse(input, v);
+    if(parsed.is_err()) {
+        return parsed.map([](auto) { return indexed_document{}; });
+    }
+
+    indexed_document result;
+    result.d_root = make_unique<document>(v.collect());
+
+    collector c(min_keys);
+    result.d_root->visit(c);
+    for(auto m : c.d_found) {
+        result.d_indexes.emplace(piecewise_construct, forward_as_tuple(m), forward_as_tuple(*m)).first->second.build();
+    }
+    return results::make_ok<indexed_document>(move(result));
+}
+
+results::result<indexed_document> load_indexed(string_view input, size_t min_keys) {
+    view_buffer buf(input);
+    istream     str(&buf);
+    return load_indexed(str, min_keys);
+}
+
+} // namespace kjson
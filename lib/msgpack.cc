@@ -0,0 +1,397 @@
+#include "msgpack.hh"
+#include "byte_stream.hh"
+#include "parser.hh"
+#include "view_buffer.hh"
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+void put_byte(string& out, uint8_t b) {
+    out += static_cast<char>(b);
+}
+
+void put_uint(string& out, uint64_t v) {
+    if(v < 0x80) {
+        put_byte(out, static_cast<uint8_t>(v));
+    } else if(v <= numeric_limits<uint8_t>::max()) {
+        put_byte(out, 0xcc);
+        put_be(out, static_cast<uint8_t>(v));
+    } else if(v <= numeric_limits<uint16_t>::max()) {
+        put_byte(out, 0xcd);
+        put_be(out, static_cast<uint16_t>(v));
+    } else if(v <= numeric_limits<uint32_t>::max()) {
+        put_byte(out, 0xce);
+        put_be(out, static_cast<uint32_t>(v));
+    } else {
+        put_byte(out, 0xcf);
+        put_be(out, v);
+    }
+}
+
+void put_int(string& out, int64_t v) {
+    if(v >= 0) {
+        put_uint(out, static_cast<uint64_t>(v));
+    } else if(v >= -32) {
+        put_byte(out, static_cast<uint8_t>(v));
+    } else if(v >= numeric_limits<int8_t>::min()) {
+        put_byte(out, 0xd0);
+        put_be(out, static_cast<uint8_t>(v));
+    } else if(v >= numeric_limits<int16_t>::min()) {
+        put_byte(out, 0xd1);
+        put_be(out, static_cast<uint16_t>(v));
+    } else if(v >= numeric_limits<int32_t>::min()) {
+        put_byte(out, 0xd2);
+        put_be(out, static_cast<uint32_t>(v));
+    } else {
+        put_byte(out, 0xd3);
+        put_be(out, static_cast<uint64_t>(v));
+    }
+}
+
+void put_str(string& out, string_view s) {
+    if(s.size() < 32) {
+        put_byte(out, static_cast<uint8_t>(0xa0 | s.size()));
+    } else if(s.size() <= numeric_limits<uint8_t>::max()) {
+        put_byte(out, 0xd9);
+        put_be(out, static_cast<uint8_t>(s.size()));
+    } else if(s.size() <= numeric_limits<uint16_t>::max()) {
+        put_byte(out, 0xda);
+        put_be(out, static_cast<uint16_t>(s.size()));
+    } else {
+        put_byte(out, 0xdb);
+        put_be(out, static_cast<uint32_t>(s.size()));
+    }
+    out.append(s.data(), s.size());
+}
+
+void put_bin(string& out, const byte* data, size_t size) {
+    if(size <= numeric_limits<uint8_t>::max()) {
+        put_byte(out, 0xc4);
+        put_be(out, static_cast<uint8_t>(size));
+    } else if(size <= numeric_limits<uint16_t>::max()) {
+        put_byte(out, 0xc5);
+        put_be(out, static_cast<uint16_t>(size));
+    } else {
+        put_byte(out, 0xc6);
+        put_be(out, static_cast<uint32_t>(size));
+    }
+    out.append(reinterpret_cast<const char*>(data), size);
+}
+
+void put_scalar(string& out, const scalar_t& v) {
+    std::visit([&out](auto&& item) {
+        using T = decay_t<decltype(item)>;
+
+        if constexpr(is_same_v<T, none>) {
+            put_byte(out, 0xc0);
+        } else if constexpr(is_same_v<T, bool>) {
+            put_byte(out, item ? 0xc3 : 0xc2);
+        } else if constexpr(is_same_v<T, int64_t>) {
+            put_int(out, item);
+        } else if constexpr(is_same_v<T, uint64_t>) {
+            put_uint(out, item);
+        } else if constexpr(is_same_v<T, double>) {
+            uint64_t bits;
+            memcpy(&bits, &item, sizeof(bits));
+            put_byte(out, 0xcb);
+            put_be(out, bits);
+        } else {
+            put_str(out, item);
+        }
+    },
+               v);
+}
+
+struct msgpack_frame {
+    bool     mapping;
+    uint64_t remaining;
+};
+
+class msgpack_reader : public stack_reader<msgpack_reader, msgpack_frame> {
+  public:
+    using stack_reader::stack_reader;
+
+  private:
+    friend class stack_reader<msgpack_reader, msgpack_frame>;
+
+    template <typename T>
+    int64_t signed_value() {
+        return static_cast<typename make_signed<T>::type>(d_input.get_be<T>());
+    }
+
+    string string_value(uint64_t size) {
+        if(size > d_limits.max_string) {
+            throw invalid_argument("string exceeds the maximum length");
+        }
+        string result;
+        d_input.read(result, size);
+        return result;
+    }
+
+    // returns the length of a string marker, or -1 if it is not a string
+    int64_t string_size(uint8_t marker) {
+        if((marker & 0xe0) == 0xa0) {
+            return marker & 0x1f;
+        }
+        switch(marker) {
+        case 0xc4:
+        case 0xd9:
+            return d_input.get();
+        case 0xc5:
+        case 0xda:
+            return d_input.get_be<uint16_t>();
+        case 0xc6:
+        case 0xdb:
+            return d_input.get_be<uint32_t>();
+        default:
+            return -1;
+        }
+    }
+
+    // reads the next member of the innermost container, or closes it
+    void next() {
+        auto& f = d_stack.back();
+        if(f.remaining == 0) {
+            close();
+            return;
+        }
+        --f.remaining;
+
+        if(!f.mapping) {
+            value(maybe_key::none(), d_input.get());
+            return;
+        }
+        auto size = string_size(d_input.get());
+        if(size < 0) {
+            throw invalid_argument("only string keys are supported");
+        }
+        d_key = string_value(static_cast<uint64_t>(size));
+        value(maybe_key::some(d_key), d_input.get());
+    }
+
+    void sequence(const maybe_key& key, uint64_t n) {
+        open(key, false, n, msgpack_frame{false, n});
+    }
+
+    void mapping(const maybe_key& key, uint64_t n) {
+        open(key, true, n, msgpack_frame{true, n});
+    }
+
+    void value(const maybe_key& key, uint8_t marker) {
+        count_node();
+
+        if(marker < 0x80) {
+            scalar(key, static_cast<uint64_t>(marker));
+            return;
+        }
+        if(marker >= 0xe0) {
+            scalar(key, static_cast<int64_t>(static_cast<int8_t>(marker)));
+            return;
+        }
+        if((marker & 0xf0) == 0x80) {
+            mapping(key, marker & 0x0f);
+            return;
+        }
+        if((marker & 0xf0) == 0x90) {
+            sequence(key, marker & 0x0f);
+            return;
+        }
+
+        auto size = string_size(marker);
+        if(size >= 0 && marker >= 0xc4 && marker <= 0xc6) {
+            binary(key, string_value(static_cast<uint64_t>(size)));
+            return;
+        } else if(size >= 0) {
+            scalar(key, string_value(static_cast<uint64_t>(size)));
+            return;
+        }
+
+        switch(marker) {
+        case 0xc0:
+            scalar(key, none{});
+            break;
+        case 0xc2:
+            scalar(key, false);
+            break;
+        case 0xc3:
+            scalar(key, true);
+            break;
+        case 0xca: {
+            auto  bits = d_input.get_be<uint32_t>();
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            scalar(key, finite(f));
+        } break;
+        case 0xcb: {
+            auto   bits = d_input.get_be<uint64_t>();
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            scalar(key, finite(d));
+        } break;
+        case 0xcc:
+            scalar(key, static_cast<uint64_t>(d_input.get()));
+            break;
+        case 0xcd:
+            scalar(key, static_cast<uint64_t>(d_input.get_be<uint16_t>()));
+            break;
+        case 0xce:
+            scalar(key, static_cast<uint64_t>(d_input.get_be<uint32_t>()));
+            break;
+        case 0xcf:
+            scalar(key, d_input.get_be<uint64_t>());
+            break;
+        case 0xd0:
+            scalar(key, signed_value<uint8_t>());
+            break;
+        case 0xd1:
+            scalar(key, signed_value<uint16_t>());
+            break;
+        case 0xd2:
+            scalar(key, signed_value<uint32_t>());
+            break;
+        case 0xd3:
+            scalar(key, signed_value<uint64_t>());
+            break;
+        case 0xdc:
+            sequence(key, d_input.get_be<uint16_t>());
+            break;
+        case 0xdd:
+            sequence(key, d_input.get_be<uint32_t>());
+            break;
+        case 0xde:
+            mapping(key, d_input.get_be<uint16_t>());
+            break;
+        case 0xdf:
+            mapping(key, d_input.get_be<uint32_t>());
+            break;
+        default:
+            throw invalid_argument("unsupported msgpack type");
+        }
+    }
+};
+
+} // namespace
+
+msgpack_writer::msgpack_writer(ostream& out)
+  : d_out(out) {
+}
+
+void msgpack_writer::scalar(scalar_t v) {
+    put_scalar(d_buffer, v);
+    written();
+}
+
+void msgpack_writer::scalar(string_view key, scalar_t v) {
+    write_key(key);
+    scalar(move(v));
+}
+
+void msgpack_writer::push_sequence() {
+    push(0xdd);
+}
+
+void msgpack_writer::push_sequence(string_view key) {
+    write_key(key);
+    push_sequence();
+}
+
+void msgpack_writer::push_mapping() {
+    push(0xdf);
+}
+
+void msgpack_writer::push_mapping(string_view key) {
+    write_key(key);
+    push_mapping();
+}
+
+void msgpack_writer::pop() {
+    auto c = d_stack.back();
+    d_stack.pop_back();
+
+    string count;
+    put_be(count, c.count);
+    d_buffer.replace(c.offset, count.size(), count);
+
+    written();
+}
+
+void msgpack_writer::binary(const byte* data, size_t size) {
+    put_bin(d_buffer, data, size);
+    written();
+}
+
+void msgpack_writer::binary(string_view key, const byte* data, size_t size) {
+    write_key(key);
+    binary(data, size);
+}
+
+void msgpack_writer::write_key(string_view key) {
+    put_str(d_buffer, key);
+}
+
+void msgpack_writer::push(uint8_t marker) {
+    put_byte(d_buffer, marker);
+    d_stack.push_back(container{d_buffer.size(), 0});
+    put_be(d_buffer, uint32_t{0});
+}
+
+void msgpack_writer::written() {
+    if(d_stack.empty()) {
+        d_out.write(d_buffer.data(), d_buffer.size());
+        d_buffer.clear();
+    } else {
+        ++d_stack.back().count;
+    }
+}
+
+maybe_error load_msgpack(istream& input, visitor& v) {
+    return load_msgpack(input, v, limits{});
+}
+
+maybe_error load_msgpack(string_view input, visitor& v) {
+    return load_msgpack(input, v, limits{});
+}
+
+result load_msgpack(istream& input) {
+    return load_msgpack(input, limits{});
+}
+
+result load_msgpack(string_view input) {
+    return load_msgpack(input, limits{});
+}
+
+maybe_error load_msgpack(istream& input, visitor& v, const limits& l) {
+    return decode<msgpack_reader>(*input.rdbuf(), v, l);
+}
+
+maybe_error load_msgpack(string_view input, visitor& v, const limits& l) {
+    view_buffer buf(input);
+    return decode<msgpack_reader>(buf, v, l);
+}
+
+result load_msgpack(istream& input, const limits& l) {
+    to_composite v;
+    return load_msgpack(input, v, l)
+        .map([&v](auto) { return v.collect(); });
+}
+
+result load_msgpack(string_view input, const limits& l) {
+    to_composite v;
+    return load_msgpack(input, v, l)
+        .map([&v](auto) { return v.collect(); });
+}
+
+void dump_msgpack(const document& data, ostream& out) {
+    msgpack_writer w(out);
+    walk(data, w);
+}
+
+} // namespace kjson
@@ -0,0 +1,152 @@
+#include "parallel_dump.hh"
+#include "json_builder.hh"
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+// Renders the items in [first, last) as the body of an opened container, that is
+// everything between the opening bracket and the closing newline and bracket.
+// The builder is in the same state as it would be when dumping serially, except
+// that the first item of a chunk is not preceded by a comma.
+template <typename iterator_t, typename item_t>
+string render_chunk(iterator_t first, iterator_t last, bool compact, bool is_mapping, item_t&& item) {
+    ostringstream buffer;
+    {
+        builder      b(buffer, compact);
+        json_builder jb(b);
+
+        if(is_mapping) {
+            b.push_mapping();
+        } else {
+            b.push_sequence();
+        }
+
+        for(; first != last; ++first) {
+            item(b, jb, *first);
+        }
+    }
+
+    string            chunk  = buffer.str();
+    string::size_type suffix = compact ? 1 : 2;
+    return chunk.substr(1, chunk.size() - 1 - suffix);
+}
+
+template <typename container_t, typename item_t>
+void render_parallel(const container_t& v,
+                     ostream&           out,
+                     bool               compact,
+                     bool               is_mapping,
+                     size_t             concurrency,
+                     item_t             item) {
+    size_t workers = min(concurrency, v.size());
+
+    vector<typename container_t::const_iterator> bounds;
+    bounds.reserve(workers + 1);
+
+    auto it = v.begin();
+    for(size_t w = 0; w < workers; ++w) {
+        bounds.push_back(it);
+        advance(it, v.size() / workers + (w < v.size() % workers ? 1 : 0));
+    }
+    bounds.push_back(v.end());
+
+    auto render = [&](size_t w) {
+        return render_chunk(bounds[w], bounds[w + 1], compact, is_mapping, item);
+    };
+
+    vector<future<string>> chunks;
+    chunks.reserve(workers - 1);
+    for(size_t w = 1; w < workers; ++w) {
+        chunks.push_back(async(launch::async, render, w));
+    }
+
+    out << (is_mapping ? '{' : '[');
+    out << render(0);
+    for(auto&& chunk : chunks) {
+        out << ',' << chunk.get();
+    }
+    if(!compact) {
+        out << '\n';
+    }
+    out << (is_mapping ? '}' : ']');
+}
+
+class parallel_json_builder {
+  public:
+    parallel_json_builder(ostream& out, bool compact, size_t concurrency)
+      : d_out(out)
+      , d_compact(compact)
+      , d_concurrency(concurrency) {
+    }
+
+    template <typename T>
+    void operator()(T&& v) {
+        json_builder jb(d_out, d_compact);
+        jb(std::forward<T>(v));
+    }
+
+    void operator()(const composite::sequence& v) {
+        if(v.size() < 2) {
+            serial(v);
+            return;
+        }
+
+        render_parallel(v, d_out, d_compact, false, d_concurrency, [](builder&, json_builder& jb, const document& item) {
+            item.visit(jb);
+        });
+    }
+
+    void operator()(const composite::mapping& v) {
+        if(v.size() < 2) {
+            serial(v);
+            return;
+        }
+
+        render_parallel(v, d_out, d_compact, true, d_concurrency, [](builder& b, json_builder& jb, auto&& kv) {
+            b.key(kv.first);
+            kv.second.visit(jb);
+        });
+    }
+
+  private:
+    template <typename T>
+    void serial(const T& v) {
+        json_builder jb(d_out, d_compact);
+        jb(v);
+    }
+
+    ostream& d_out;
+    bool     d_compact;
+    size_t   d_concurrency;
+};
+
+} // namespace
+
+void parallel_dump(const document& data, ostream& out, bool compact, size_t concurrency) {
+    if(concurrency == 0) {
+        concurrency = max(1u, thread::hardware_concurrency());
+    }
+
+    if(concurrency == 1) {
+        json_builder jb(out, compact);
+        data.visit(jb);
+        return;
+    }
+
+    parallel_json_builder pjb(out, compact, concurrency);
+    data.visit(pjb);
+}
+
+} // namespace kjson
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "json.hh"
+#include <cstddef>
+#include <iosfwd>
+
+namespace kjson {
+
+// Serializes the children of a top-level sequence or mapping on up to
+// `concurrency` threads; the output is identical to a serial dump.
+void parallel_dump(document const& data, std::ostream& out, bool compact, std::size_t concurrency);
+
+} // namespace kjson
@@ -1,9 +1,14 @@
 #include "parser.hh"
+#include "counting_buffer.hh"
+#include "instrument.hh"
 #include "tokenizer.hh"
 #include "visitor.hh"
 #include <composite/make.hh>
-#include <cstdlib>
+#include <cstddef>
+#include <istream>
+#include <limits>
 #include <utility>
+#include <vector>
 
 namespace kjson {
 
@@ -12,182 +17,205 @@ using namespace results;
 
 namespace {
 
-template <typename T>
-T from_string(const string& v);
-
-template <>
-uint64_t from_string<uint64_t>(const string& v) {
-    char* end;
-
-    static_assert(sizeof(decltype(std::strtoull("", &end, 10))) >= sizeof(uint64_t), "unsigned long long not long enough");
-
-    return std::strtoull(v.data(), &end, 10);
-}
-
-template <>
-int64_t from_string<int64_t>(const string& v) {
-    char* end;
-
-    static_assert(sizeof(decltype(std::strtoll("", &end, 10))) >= sizeof(uint64_t), "long long not long enough");
-
-    return std::strtoll(v.data(), &end, 10);
-}
-
-template <>
-double from_string<double>(const string& v) {
-    char* end;
-
-    static_assert(sizeof(decltype(std::strtod("", &end))) >= sizeof(double), "not long enough");
-
-    return std::strtod(v.data(), &end);
-}
-
-using maybe_key = results::option<string_view>;
-
 class parser {
   public:
-    parser(istream& input, visitor& visitor)
+    parser(streambuf& input, visitor& visitor, parse_buffers& buffers, const limits& l)
       : d_stream(input)
       , d_visitor(visitor)
-      , d_token{token::type_t::e_eof} {
+      , d_limits(l)
+      , d_token(buffers.current)
+      , d_key(buffers.key)
+      , d_stack(buffers.stack)
+      , d_bytes(buffers.bytes) {
+        d_stack.clear();
     }
 
     maybe_error parse();
 
   private:
-    maybe_error mapping(const maybe_key& key);
-    maybe_error sequence(const maybe_key& key);
-    maybe_error value(const maybe_key& key);
-    void        elements();
-    void        members();
-    maybe_error kv_pair();
-
-    maybe_error extract_value(const maybe_key& key);
-
-    const token& current() {
-        return d_token;
+    maybe_error next();
+    maybe_error member();
+    maybe_error value(bool keyed);
+    maybe_error open(bool keyed);
+    maybe_error scalar(bool keyed, scalar_t v);
+    maybe_error number(bool keyed);
+    maybe_error extract_binary(bool keyed);
+
+    maybe_error advance() {
+        phase_timer t(&stats::tokenize);
+        trace_part  part(trace_phase::e_tokenize);
+        auto        r = next_token(d_stream, d_token, true, d_limits.max_string);
+        part.bytes(d_token.value.size());
+        return r;
     }
 
-    token_error<token> advance() {
-        return next_token(d_stream).map([this](auto&& t) {
-            this->d_token = t;
-            return t;
-        });
+    maybe_error read_string() {
+        phase_timer t(&stats::tokenize);
+        trace_part  part(trace_phase::e_tokenize);
+        auto        r = next_string(d_stream, d_token, d_limits.max_string);
+        part.bytes(d_token.value.size());
+        return r;
     }
 
-    token_error<token> match_and_consume(token::type_t expect) {
-        if(current().tok != expect)
-            return make_err<token>("unexpected token");
+    maybe_error match_and_consume(token::type_t expect) {
+        if(d_token.tok != expect)
+            return maybe_error::err("unexpected token");
         else
             return advance();
     }
 
-    istream& d_stream;
-    visitor& d_visitor;
-    token    d_token;
+    streambuf&                d_stream;
+    visitor&                  d_visitor;
+    const limits&             d_limits;
+    token&                    d_token;
+    pmr::string&              d_key;
+    pmr::vector<parse_frame>& d_stack;
+    pmr::vector<byte>&        d_bytes;
+
+    // no separator is expected before the next member or element
+    bool   d_first{true};
+    size_t d_nodes{0};
 };
 
+// one value, then the members of the open containers until d_stack is empty
 maybe_error parser::parse() {
-    return advance()
-        .and_then([this](auto) { return value(maybe_key::none()); })
-        .and_then([this](auto v) {
-            return match_and_consume(token::type_t::e_eof).map([&](auto) {
-                return v;
-            });
-        });
-}
-
-maybe_error parser::mapping(const maybe_key& key) {
-    return match_and_consume(token::type_t::e_start_mapping)
-        .map([this, &key](auto) {
-            key.match(
-                [this](string_view k) { d_visitor.push_mapping(k); },
-                [this] { d_visitor.push_mapping(); });
-            members();
-            d_visitor.pop();
-            return maybe_error::ok(std::monostate{});
-        })
-        .and_then([this](auto) {
-            return match_and_consume(token::type_t::e_end_mapping)
-                .map([](auto) { return std::monostate{}; });
-        });
-}
-
-maybe_error parser::sequence(const maybe_key& key) {
-    return match_and_consume(token::type_t::e_start_sequence)
-        .map([this, &key](auto) {
-            key.match(
-                [this](string_view k) { d_visitor.push_sequence(k); },
-                [this] { d_visitor.push_sequence(); });
-            elements();
-            d_visitor.pop();
-            return 0;
-        })
-        .and_then([this](auto) {
-            return match_and_consume(token::type_t::e_end_sequence)
-                .map([](auto) { return std::monostate{}; });
-        });
+    auto r = advance().and_then([this](auto) { return value(false); });
+    while(r.is_ok() && !d_stack.empty())
+        r = next();
+
+    return r.and_then([this](auto) {
+        if(d_token.tok != token::type_t::e_eof)
+            return maybe_error::err("unexpected token");
+        return maybe_error::ok(std::monostate{});
+    });
 }
 
-maybe_error parser::value(const maybe_key& key) {
-    return mapping(key)
-        .or_else([this, &key] { return sequence(key); })
-        .or_else([this, &key] { return extract_value(key); });
+maybe_error parser::next() {
+    bool mapping = d_stack.back().type == token::type_t::e_start_mapping;
+    auto end     = mapping ? token::type_t::e_end_mapping : token::type_t::e_end_sequence;
+
+    if(d_token.tok == end) {
+        d_visitor.pop();
+        d_stack.pop_back();
+        d_first = false;
+        return advance();
+    }
+
+    if(!d_first) {
+        d_first = true;
+        return match_and_consume(token::type_t::e_separator);
+    }
+
+    if(++d_stack.back().members > d_limits.max_members)
+        return maybe_error::err("container exceeds the maximum number of members");
+
+    d_first = false;
+    return mapping ? member() : value(false);
 }
 
-maybe_error parser::extract_value(const maybe_key& key) {
-    auto ok = [this, &key](auto&& v) {
-        scalar_t c(std::move(v));
-        key.match(
-            [this, &c](string_view k) { d_visitor.scalar(k, std::move(c)); },
-            [this, &c] { d_visitor.scalar(std::move(c)); });
-        return advance()
-            .map([](auto&) { return std::monostate{}; });
-    };
+maybe_error parser::member() {
+    if(d_token.tok != token::type_t::e_string)
+        return maybe_error::err("key is not a string");
 
-    switch(current().tok) {
+    return read_string()
+        .and_then([this](auto) {
+            // both strings keep their capacity, whichever holds the key
+            swap(d_key, d_token.value);
+            return advance();
+        })
+        .and_then([this](auto) { return match_and_consume(token::type_t::e_mapper); })
+        .and_then([this](auto) { return value(true); });
+}
+
+maybe_error parser::value(bool keyed) {
+    record([](stats& s) { ++s.nodes; });
+    if(++d_nodes > d_limits.max_nodes)
+        return maybe_error::err("document exceeds the maximum number of nodes");
+
+    switch(d_token.tok) {
+    case token::type_t::e_start_mapping:
+    case token::type_t::e_start_sequence:
+        return open(keyed);
     case token::type_t::e_int:
-        return ok(from_string<int64_t>(current().value));
     case token::type_t::e_uint:
-        return ok(from_string<uint64_t>(current().value));
     case token::type_t::e_float:
-        return ok(from_string<double>(current().value));
+        return number(keyed);
     case token::type_t::e_string:
-        return ok(current().value);
+        if(keyed ? d_visitor.expect_binary(d_key) : d_visitor.expect_binary())
+            return extract_binary(keyed);
+        return read_string().and_then([this, keyed](auto) { return scalar(keyed, string(d_token.value)); });
     case token::type_t::e_true:
-        return ok(true);
+        return scalar(keyed, true);
     case token::type_t::e_false:
-        return ok(false);
+        return scalar(keyed, false);
     case token::type_t::e_null:
-        return ok(none{});
+        return scalar(keyed, none{});
     default:
         return maybe_error::err("failed to extract value");
     }
 }
 
-void parser::elements() {
-    while(value(maybe_key::none()).is_ok() &&
-          match_and_consume(token::type_t::e_separator).is_ok())
-        ;
+maybe_error parser::open(bool keyed) {
+    if(d_stack.size() >= d_limits.max_depth)
+        return maybe_error::err("document exceeds the maximum depth");
+
+    if(d_token.tok == token::type_t::e_start_mapping) {
+        if(keyed)
+            d_visitor.push_mapping(d_key);
+        else
+            d_visitor.push_mapping();
+    } else {
+        if(keyed)
+            d_visitor.push_sequence(d_key);
+        else
+            d_visitor.push_sequence();
+    }
+
+    d_stack.push_back(parse_frame{d_token.tok, 0});
+    record_depth(d_stack.size());
+    d_first = true;
+    return advance();
 }
 
-void parser::members() {
-    while(kv_pair().is_ok() &&
-          match_and_consume(token::type_t::e_separator).is_ok())
-        ;
+maybe_error parser::scalar(bool keyed, scalar_t v) {
+    if(keyed)
+        d_visitor.scalar(d_key, std::move(v));
+    else
+        d_visitor.scalar(std::move(v));
+    return advance();
 }
 
-maybe_error parser::kv_pair() {
-    if(current().tok != token::type_t::e_string)
-        return maybe_error::err("key is not a string");
+// converting the text is left to the visitor
+maybe_error parser::number(bool keyed) {
+    raw_number n{d_token.value};
+    if(keyed)
+        d_visitor.number(d_key, n);
+    else
+        d_visitor.number(n);
+    return advance();
+}
 
-    string key = std::move(d_token.value);
-    advance();
+maybe_error parser::extract_binary(bool keyed) {
+    auto decoded = [this] {
+        phase_timer t(&stats::tokenize);
+        trace_part  part(trace_phase::e_tokenize);
+        auto        r = next_binary(d_stream, d_bytes, d_limits.max_string);
+        part.bytes(d_bytes.size());
+        return r;
+    };
 
-    return match_and_consume(token::type_t::e_mapper)
-        .and_then([this, &key](auto) {
-            return value(maybe_key::some(key));
-        });
+    return decoded().and_then([this, keyed](auto) {
+        if(keyed)
+            d_visitor.binary(d_key, d_bytes.data(), d_bytes.size());
+        else
+            d_visitor.binary(d_bytes.data(), d_bytes.size());
+        return advance();
+    });
+}
+
+size_t string_size(const scalar_t& v) {
+    auto s = get_if<string>(&v);
+    return s ? s->size() : 0;
 }
 
 composite::composite from_scalar(scalar_t v) {
@@ -202,42 +230,89 @@ composite::composite from_scalar(scalar_t v) {
                  v);
 }
 
-} // namespace
-
-maybe_error parse(istream& input, visitor& visitor) {
+maybe_error parse_input(streambuf& input, visitor& visitor, parse_buffers& buffers, const limits& l) {
     try {
-        parser p(input, visitor);
-        return p.parse();
+        if(l.max_size == numeric_limits<size_t>::max()) {
+            parser p(input, visitor, buffers, l);
+            return p.parse();
+        }
+
+        // the input ends at the limit, so parsing stops there
+        size_t          read = 0;
+        counting_buffer buf(input, read, l.max_size);
+        parser          p(buf, visitor, buffers, l);
+        auto            r = p.parse();
+        if(buf.exceeded())
+            return maybe_error::err("document exceeds the maximum size");
+        return r;
     } catch(const std::exception& e) {
         return maybe_error::err(e.what());
     }
 }
 
+} // namespace
+
+maybe_error parse(istream& input, visitor& visitor) {
+    return parse(*input.rdbuf(), visitor);
+}
+
+maybe_error parse(istream& input, visitor& visitor, parse_buffers& buffers, const limits& l) {
+    return parse(*input.rdbuf(), visitor, buffers, l);
+}
+
+maybe_error parse(streambuf& input, visitor& visitor) {
+    parse_buffers buffers;
+    return parse(input, visitor, buffers);
+}
+
+maybe_error parse(streambuf& input, visitor& visitor, parse_buffers& buffers, const limits& l) {
+    trace_span span(trace_phase::e_parse);
+    if(!span.active())
+        return parse_input(input, visitor, buffers, l);
+
+    const streampos unknown(-1);
+    auto            start = input.pubseekoff(0, ios_base::cur, ios_base::in);
+    auto            r     = parse_input(input, visitor, buffers, l);
+    auto            end   = input.pubseekoff(0, ios_base::cur, ios_base::in);
+    if(start != unknown && end != unknown)
+        span.bytes(static_cast<size_t>(end - start));
+    return r;
+}
+
 void to_composite::scalar(scalar_t v) {
+    trace_part part(trace_phase::e_build);
+    part.bytes(string_size(v));
     d_builder.with(from_scalar(v));
 }
 
 void to_composite::scalar(string_view key, scalar_t v) {
+    trace_part part(trace_phase::e_build);
+    part.bytes(string_size(v));
     d_builder.with(key, from_scalar(v));
 }
 
 void to_composite::push_sequence() {
+    trace_part part(trace_phase::e_build);
     d_builder.push_sequence();
 }
 
 void to_composite::push_sequence(string_view key) {
+    trace_part part(trace_phase::e_build);
     d_builder.push_sequence(key);
 }
 
 void to_composite::push_mapping() {
+    trace_part part(trace_phase::e_build);
     d_builder.push_mapping();
 }
 
 void to_composite::push_mapping(string_view key) {
+    trace_part part(trace_phase::e_build);
     d_builder.push_mapping(key);
 }
 
 void to_composite::pop() {
+    trace_part part(trace_phase::e_build);
     d_builder.pop();
 }
 
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "json.hh"
+#include "tokenizer.hh"
 #include "visitor.hh"
 #include <composite/builder.hh>
+#include <cstddef>
 #include <iosfwd>
+#include <memory_resource>
+#include <string>
+#include <vector>
 
 namespace kjson {
 
@@ -26,6 +31,33 @@ class to_composite : public visitor {
     composite::builder d_builder;
 };
 
+// Scratch space of the parser; a reader keeps one across parses so that the
+// buffers only grow to the largest document seen.
+struct parse_frame {
+    token::type_t type;
+    std::size_t   members;
+};
+
+struct parse_buffers {
+    explicit parse_buffers(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+      : current{token::type_t::e_eof, std::pmr::string(resource)}
+      , key(resource)
+      , stack(resource)
+      , bytes(resource) {
+    }
+
+    token                           current;
+    std::pmr::string                key;
+    std::pmr::vector<parse_frame>   stack;
+    std::pmr::vector<std::byte>     bytes;
+};
+
 maybe_error parse(std::istream& input, visitor& visitor);
+maybe_error parse(std::istream& input, visitor& visitor, parse_buffers& buffers, limits const& l = {});
+
+// Parsing from a stream buffer avoids constructing an istream, which copies
+// the shared global locale.
+maybe_error parse(std::streambuf& input, visitor& visitor);
+maybe_error parse(std::streambuf& input, visitor& visitor, parse_buffers& buffers, limits const& l = {});
 
 } // namespace kjson
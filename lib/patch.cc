@@ -0,0 +1,629 @@
+#include "patch.hh"
+#include "escape.hh"
+#include "json_writer.hh"
+#include "tokenizer.hh"
+#include "tree.hh"
+#include "view_buffer.hh"
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+constexpr size_t flush_size = 64 * 1024;
+
+struct operation {
+    enum kind_t {
+        e_add,
+        e_remove,
+        e_replace,
+    };
+
+    kind_t         kind;
+    vector<string> path;
+    const tree*    value;
+};
+
+using operations = vector<const operation*>;
+
+vector<string> parse_pointer(const string& pointer) {
+    vector<string> tokens;
+    if(pointer.empty()) {
+        return tokens;
+    }
+    if(pointer[0] != '/') {
+        throw invalid_argument("invalid path " + pointer);
+    }
+
+    for(size_t i = 1; i <= pointer.size(); ++i) {
+        if(i == 1 || pointer[i - 1] == '/') {
+            tokens.emplace_back();
+        }
+        if(i == pointer.size()) {
+            break;
+        }
+
+        char c = pointer[i];
+        if(c == '/') {
+            continue;
+        } else if(c == '~' && i + 1 < pointer.size() && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+            tokens.back() += pointer[++i] == '0' ? '~' : '/';
+        } else {
+            tokens.back() += c;
+        }
+    }
+    return tokens;
+}
+
+const string* text(const tree* t) {
+    return t && t->kind == tree::e_scalar ? get_if<string>(&t->value) : nullptr;
+}
+
+vector<operation> parse_operations(const tree& patch) {
+    if(patch.kind != tree::e_sequence) {
+        throw invalid_argument("a json patch must be an array");
+    }
+
+    vector<operation> result;
+    for(auto&& item : patch.items) {
+        auto name = text(item.find("op"));
+        auto path = text(item.find("path"));
+        if(item.kind != tree::e_mapping || !name || !path) {
+            throw invalid_argument("an operation needs an op and a path");
+        }
+
+        operation o{operation::e_add, parse_pointer(*path), item.find("value")};
+        if(*name == "add") {
+            o.kind = operation::e_add;
+        } else if(*name == "remove") {
+            o.kind = operation::e_remove;
+        } else if(*name == "replace") {
+            o.kind = operation::e_replace;
+        } else {
+            throw invalid_argument("unsupported operation " + *name);
+        }
+
+        if(o.kind != operation::e_remove && !o.value) {
+            throw invalid_argument(*name + " needs a value");
+        }
+        result.push_back(move(o));
+    }
+    return result;
+}
+
+// What the operations on one position add up to, applied in order. Descendant
+// operations are kept for when the original value is streamed.
+struct plan {
+    enum kind_t {
+        e_original,
+        e_set,
+        e_absent,
+    };
+
+    kind_t      kind{e_original};
+    bool        must_exist{false};
+    const tree* value{nullptr};
+    operations  nested;
+};
+
+plan compose(const operations& ops, size_t depth) {
+    plan p;
+    for(auto o : ops) {
+        bool direct = o->path.size() == depth;
+        if(p.kind == plan::e_absent && (!direct || o->kind != operation::e_add)) {
+            throw invalid_argument("path does not exist");
+        }
+        if(p.kind == plan::e_original && (!direct || o->kind != operation::e_add)) {
+            p.must_exist = true;
+        }
+
+        if(!direct) {
+            if(p.kind == plan::e_set) {
+                throw invalid_argument("can not patch a value added by the same patch");
+            }
+            p.nested.push_back(o);
+        } else if(o->kind == operation::e_remove) {
+            p.kind  = plan::e_absent;
+            p.value = nullptr;
+            p.nested.clear();
+        } else {
+            p.kind  = plan::e_set;
+            p.value = o->value;
+            p.nested.clear();
+        }
+    }
+    return p;
+}
+
+bool parse_index(const string& token, size_t& index) {
+    if(token.empty() || token.size() > 18 || (token.size() > 1 && token[0] == '0')) {
+        return false;
+    }
+    index = 0;
+    for(char c : token) {
+        if(c < '0' || c > '9') {
+            return false;
+        }
+        index = index * 10 + (c - '0');
+    }
+    return true;
+}
+
+// The elements of a patched sequence: the original elements before
+// d_next_original, in their new order and interleaved with inserted values, then
+// the untouched originals, then values appended with "-".
+class sequence_plan {
+  public:
+    struct entry {
+        bool        original;
+        size_t      index;
+        const tree* value;
+        operations  nested;
+    };
+
+    sequence_plan(const operations& ops, size_t depth) {
+        for(auto o : ops) {
+            auto& token  = o->path[depth];
+            bool  direct = o->path.size() == depth + 1;
+
+            if(token == "-") {
+                if(!direct || o->kind != operation::e_add) {
+                    throw invalid_argument("'-' can only be used to append");
+                }
+                d_tail.push_back(o->value);
+                continue;
+            }
+
+            size_t i;
+            if(!parse_index(token, i)) {
+                throw invalid_argument("invalid array index " + token);
+            }
+
+            if(direct && o->kind == operation::e_add) {
+                cover(i);
+                d_entries.insert(d_entries.begin() + i, entry{false, 0, o->value, {}});
+                continue;
+            }
+
+            cover(i + 1);
+            auto& e = d_entries[i];
+            if(!direct) {
+                if(!e.original) {
+                    throw invalid_argument("can not patch a value added by the same patch");
+                }
+                e.nested.push_back(o);
+            } else if(o->kind == operation::e_remove) {
+                d_entries.erase(d_entries.begin() + i);
+            } else {
+                e = entry{false, 0, o->value, {}};
+            }
+        }
+    }
+
+    const vector<entry>&       entries() const {
+        return d_entries;
+    }
+    const vector<const tree*>& tail() const {
+        return d_tail;
+    }
+    size_t next_original() const {
+        return d_next_original;
+    }
+
+  private:
+    // makes sure the first n elements are planned, pulling in originals
+    void cover(size_t n) {
+        while(d_entries.size() < n) {
+            if(!d_tail.empty()) {
+                throw invalid_argument("can not index past an append");
+            }
+            d_entries.push_back(entry{true, d_next_original++, nullptr, {}});
+        }
+    }
+
+    vector<entry>       d_entries;
+    vector<const tree*> d_tail;
+    size_t              d_next_original{0};
+};
+
+class patcher {
+  public:
+    patcher(istream& input, ostream& out)
+      : d_in(*input.rdbuf())
+      , d_out(out) {
+    }
+
+    void apply(const vector<operation>& ops) {
+        operations all;
+        for(auto&& o : ops) {
+            all.push_back(&o);
+        }
+
+        auto p = compose(all, 0);
+        if(p.kind == plan::e_absent) {
+            throw invalid_argument("can not remove the document");
+        }
+        if(p.kind == plan::e_set) {
+            skip_value();
+            write(*p.value);
+        } else {
+            value(p.nested, 0);
+        }
+        finish();
+    }
+
+    void merge(const tree& patch) {
+        merge_value(patch);
+        finish();
+    }
+
+  private:
+    void finish() {
+        if(peek() != char_traits<char>::eof()) {
+            throw invalid_argument("trailing characters");
+        }
+        flush();
+    }
+
+    int peek() {
+        int c;
+        while((c = d_in.sgetc()) == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            d_in.sbumpc();
+        }
+        return c;
+    }
+
+    char get() {
+        int c = peek();
+        if(c == char_traits<char>::eof()) {
+            throw invalid_argument("unexpected end of input");
+        }
+        return static_cast<char>(d_in.sbumpc());
+    }
+
+    void expect(char c) {
+        if(get() != c) {
+            throw invalid_argument(string("expected '") + c + "'");
+        }
+    }
+
+    void put(char c) {
+        d_buffer.push_back(c);
+    }
+
+    void flush() {
+        d_out.write(d_buffer.data(), d_buffer.size());
+        d_buffer.clear();
+    }
+
+    // new values are written through a json_writer after the copied bytes
+    void write(const tree& t) {
+        flush();
+        {
+            json_writer w(d_out);
+            replay(t, w);
+        }
+    }
+
+    // a string whose opening quote has been read, as it appears in the input
+    void raw_string(string* out) {
+        for(;;) {
+            int c = d_in.sbumpc();
+            if(c == char_traits<char>::eof()) {
+                throw invalid_argument("unterminated string");
+            }
+            if(out) {
+                out->push_back(static_cast<char>(c));
+            }
+            if(c == '\\') {
+                c = d_in.sbumpc();
+                if(out && c != char_traits<char>::eof()) {
+                    out->push_back(static_cast<char>(c));
+                }
+            } else if(c == '"') {
+                return;
+            }
+        }
+    }
+
+    // copies or skips a value without decoding it
+    void scan_value(bool copy) {
+        size_t depth = 0;
+        do {
+            char c = get();
+            if(copy) {
+                put(c);
+            }
+
+            if(c == '"') {
+                raw_string(copy ? &d_buffer : nullptr);
+            } else if(c == '{' || c == '[') {
+                ++depth;
+            } else if(c == '}' || c == ']') {
+                if(depth == 0) {
+                    throw invalid_argument(string("unexpected '") + c + "'");
+                }
+                --depth;
+            } else if(c != ',' && c != ':') {
+                for(int n; (n = d_in.sgetc()) != char_traits<char>::eof() && n != ',' && n != '}' && n != ']' &&
+                           n != ' ' && n != '\n' && n != '\r' && n != '\t';) {
+                    d_in.sbumpc();
+                    if(copy) {
+                        put(static_cast<char>(n));
+                    }
+                }
+            }
+        } while(depth > 0);
+
+        if(d_buffer.size() >= flush_size) {
+            flush();
+        }
+    }
+
+    void copy_value() {
+        scan_value(true);
+    }
+
+    void skip_value() {
+        scan_value(false);
+    }
+
+    // reads a member key, returning it decoded and appending it as is to raw
+    string key(string& raw) {
+        expect('"');
+        raw = "\"";
+        raw_string(&raw);
+
+        if(raw.find('\\') == string::npos) {
+            return raw.substr(1, raw.size() - 2);
+        }
+
+        view_buffer buf(string_view(raw).substr(1));
+        istream     str(&buf);
+        return string(next_string(str).unwrap().value);
+    }
+
+    void value(const operations& ops, size_t depth) {
+        if(ops.empty()) {
+            copy_value();
+            return;
+        }
+
+        int c = peek();
+        if(c == '{') {
+            mapping(ops, depth);
+        } else if(c == '[') {
+            sequence(ops, depth);
+        } else {
+            throw invalid_argument("path does not exist");
+        }
+    }
+
+    void mapping(const operations& ops, size_t depth) {
+        vector<pair<string, operations>> groups;
+        for(auto o : ops) {
+            auto& token = o->path[depth];
+            auto  it    = find_if(groups.begin(), groups.end(), [&token](auto&& g) { return g.first == token; });
+            if(it == groups.end()) {
+                groups.emplace_back(token, operations{});
+                it = groups.end() - 1;
+            }
+            it->second.push_back(o);
+        }
+
+        vector<pair<string, plan>> plans;
+        for(auto&& g : groups) {
+            plans.emplace_back(g.first, compose(g.second, depth + 1));
+        }
+        vector<bool> seen(plans.size());
+
+        expect('{');
+        put('{');
+        bool first = true;
+        string raw;
+
+        if(peek() != '}') {
+            do {
+                auto name = key(raw);
+                expect(':');
+
+                auto it = find_if(plans.begin(), plans.end(), [&name](auto&& p) { return p.first == name; });
+                if(it == plans.end()) {
+                    member(first, raw);
+                    copy_value();
+                    continue;
+                }
+
+                seen[it - plans.begin()] = true;
+                auto& p                  = it->second;
+                if(p.kind == plan::e_absent) {
+                    skip_value();
+                } else if(p.kind == plan::e_set) {
+                    skip_value();
+                    member(first, raw);
+                    write(*p.value);
+                } else {
+                    member(first, raw);
+                    value(p.nested, depth + 1);
+                }
+            } while(peek() == ',' && get());
+        }
+        expect('}');
+
+        for(size_t i = 0; i < plans.size(); ++i) {
+            auto& p = plans[i].second;
+            if(!seen[i] && p.must_exist) {
+                throw invalid_argument("path does not exist");
+            }
+            if(!seen[i] && p.kind == plan::e_set) {
+                member(first, escape(plans[i].first));
+                write(*p.value);
+            }
+        }
+        put('}');
+    }
+
+    void sequence(const operations& ops, size_t depth) {
+        sequence_plan p(ops, depth);
+        auto&         entries = p.entries();
+        size_t        next    = 0;
+        bool          first   = true;
+
+        auto inserted = [&](size_t until) {
+            for(; next < until && !entries[next].original; ++next) {
+                element(first);
+                write(*entries[next].value);
+            }
+        };
+
+        expect('[');
+        put('[');
+
+        size_t index = 0;
+        if(peek() != ']') {
+            do {
+                inserted(entries.size());
+                if(index >= p.next_original()) {
+                    element(first);
+                    copy_value();
+                } else if(next < entries.size() && entries[next].index == index) {
+                    element(first);
+                    value(entries[next].nested, depth + 1);
+                    ++next;
+                } else {
+                    skip_value();
+                }
+                ++index;
+            } while(peek() == ',' && get());
+        }
+        expect(']');
+
+        if(index < p.next_original()) {
+            throw invalid_argument("array index out of range");
+        }
+        inserted(entries.size());
+        for(auto v : p.tail()) {
+            element(first);
+            write(*v);
+        }
+        put(']');
+    }
+
+    void member(bool& first, const string& raw_key) {
+        if(!first) {
+            put(',');
+        }
+        first = false;
+        d_buffer += raw_key;
+        put(':');
+    }
+
+    void element(bool& first) {
+        if(!first) {
+            put(',');
+        }
+        first = false;
+    }
+
+    // RFC 7386: mappings merge, nulls remove and anything else replaces
+    void merge_value(const tree& patch) {
+        if(patch.kind != tree::e_mapping || peek() != '{') {
+            skip_value();
+            write(without_nulls(patch));
+            return;
+        }
+
+        vector<bool> seen(patch.members.size());
+        expect('{');
+        put('{');
+        bool   first = true;
+        string raw;
+
+        if(peek() != '}') {
+            do {
+                auto name = key(raw);
+                expect(':');
+
+                auto it = find_if(patch.members.begin(), patch.members.end(), [&name](auto&& m) { return m.first == name; });
+                if(it == patch.members.end()) {
+                    member(first, raw);
+                    copy_value();
+                    continue;
+                }
+
+                seen[it - patch.members.begin()] = true;
+                if(it->second.kind == tree::e_scalar && holds_alternative<none>(it->second.value)) {
+                    skip_value();
+                } else {
+                    member(first, raw);
+                    merge_value(it->second);
+                }
+            } while(peek() == ',' && get());
+        }
+        expect('}');
+
+        for(size_t i = 0; i < patch.members.size(); ++i) {
+            auto& m = patch.members[i];
+            if(!seen[i] && !(m.second.kind == tree::e_scalar && holds_alternative<none>(m.second.value))) {
+                member(first, escape(m.first));
+                write(without_nulls(m.second));
+            }
+        }
+        put('}');
+    }
+
+    static tree without_nulls(const tree& t) {
+        if(t.kind != tree::e_mapping) {
+            return t;
+        }
+
+        tree result;
+        result.kind = tree::e_mapping;
+        for(auto&& m : t.members) {
+            if(!(m.second.kind == tree::e_scalar && holds_alternative<none>(m.second.value))) {
+                result.members.emplace_back(m.first, without_nulls(m.second));
+            }
+        }
+        return result;
+    }
+
+    streambuf& d_in;
+    ostream&   d_out;
+    string     d_buffer;
+};
+
+} // namespace
+
+maybe_error apply_patch(istream& input, const document& patch, ostream& out, patch_format format) {
+    try {
+        tree_builder b;
+        walk(patch, b);
+        auto p = b.collect();
+
+        patcher w(input, out);
+        if(format == patch_format::e_merge_patch) {
+            w.merge(p);
+        } else {
+            w.apply(parse_operations(p));
+        }
+        return maybe_error::ok(std::monostate{});
+    } catch(const std::exception& e) {
+        return maybe_error::err(e.what());
+    }
+}
+
+maybe_error apply_patch(string_view input, const document& patch, ostream& out, patch_format format) {
+    view_buffer buf(input);
+    istream     str(&buf);
+    return apply_patch(str, patch, out, format);
+}
+
+} // namespace kjson
@@ -0,0 +1,695 @@
+#include "query.hh"
+#include "json_writer.hh"
+#include "tree.hh"
+#include <cstdlib>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+struct segment {
+    enum kind_t {
+        e_field,
+        e_index,
+        e_iterate,
+    };
+
+    kind_t kind;
+    string name;
+    size_t index{0};
+};
+
+using path = vector<segment>;
+
+struct operand {
+    bool     is_path{false};
+    path     steps;
+    scalar_t literal;
+};
+
+struct condition {
+    enum kind_t {
+        e_truthy,
+        e_eq,
+        e_ne,
+        e_lt,
+        e_le,
+        e_gt,
+        e_ge,
+        e_and,
+        e_or,
+    };
+
+    kind_t            kind{e_truthy};
+    operand           lhs;
+    operand           rhs;
+    vector<condition> terms;
+};
+
+struct field {
+    string name;
+    path   steps;
+};
+
+struct stage {
+    enum kind_t {
+        e_path,
+        e_select,
+        e_object,
+    };
+
+    kind_t        kind;
+    path          steps;
+    condition     test;
+    vector<field> fields;
+};
+
+bool is_ident(char c, bool first) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (!first && c >= '0' && c <= '9');
+}
+
+class query_parser {
+  public:
+    explicit query_parser(string_view input)
+      : d_input(input) {
+    }
+
+    vector<stage> parse() {
+        vector<stage> stages;
+        do {
+            stages.push_back(parse_stage());
+        } while(accept('|'));
+
+        skip_whitespace();
+        if(d_pos != d_input.size()) {
+            fail("unexpected input");
+        }
+        return stages;
+    }
+
+  private:
+    [[noreturn]] void fail(const string& what) const {
+        throw query_error(what + " at offset " + to_string(d_pos));
+    }
+
+    void skip_whitespace() {
+        while(d_pos < d_input.size() && (d_input[d_pos] == ' ' || d_input[d_pos] == '\t' || d_input[d_pos] == '\n')) {
+            ++d_pos;
+        }
+    }
+
+    char peek() {
+        skip_whitespace();
+        return d_pos < d_input.size() ? d_input[d_pos] : '\0';
+    }
+
+    bool accept(char c) {
+        if(peek() == c) {
+            ++d_pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if(!accept(c)) {
+            fail(string("expected '") + c + "'");
+        }
+    }
+
+    bool accept_word(string_view word) {
+        skip_whitespace();
+        auto end = d_pos + word.size();
+        if(d_input.substr(d_pos, word.size()) == word && (end == d_input.size() || !is_ident(d_input[end], false))) {
+            d_pos = end;
+            return true;
+        }
+        return false;
+    }
+
+    string identifier() {
+        skip_whitespace();
+        auto start = d_pos;
+        while(d_pos < d_input.size() && is_ident(d_input[d_pos], d_pos == start)) {
+            ++d_pos;
+        }
+        if(start == d_pos) {
+            fail("expected a name");
+        }
+        return string(d_input.substr(start, d_pos - start));
+    }
+
+    string quoted() {
+        expect('"');
+        string result;
+        while(d_pos < d_input.size() && d_input[d_pos] != '"') {
+            if(d_input[d_pos] == '\\' && d_pos + 1 < d_input.size()) {
+                ++d_pos;
+            }
+            result += d_input[d_pos++];
+        }
+        if(d_pos == d_input.size()) {
+            fail("unterminated string");
+        }
+        ++d_pos;
+        return result;
+    }
+
+    stage parse_stage() {
+        stage s{stage::e_path, {}, {}, {}};
+        if(peek() == '.') {
+            s.steps = parse_path();
+        } else if(accept_word("select")) {
+            s.kind = stage::e_select;
+            expect('(');
+            s.test = parse_or();
+            expect(')');
+        } else if(accept('{')) {
+            s.kind = stage::e_object;
+            do {
+                field f;
+                f.name = peek() == '"' ? quoted() : identifier();
+                if(accept(':')) {
+                    f.steps = parse_path();
+                } else {
+                    f.steps = {segment{segment::e_field, f.name}};
+                }
+                s.fields.push_back(move(f));
+            } while(accept(','));
+            expect('}');
+        } else {
+            fail("expected a path, select() or an object");
+        }
+        return s;
+    }
+
+    // the leading '.' may be followed directly by a name or a bracket
+    path parse_path() {
+        path result;
+        expect('.');
+        if(d_pos < d_input.size() && is_ident(d_input[d_pos], true)) {
+            result.push_back({segment::e_field, identifier()});
+        }
+
+        for(;;) {
+            if(d_pos < d_input.size() && d_input[d_pos] == '[') {
+                ++d_pos;
+                result.push_back(bracket());
+            } else if(d_pos + 1 < d_input.size() && d_input[d_pos] == '.' && is_ident(d_input[d_pos + 1], true)) {
+                ++d_pos;
+                result.push_back({segment::e_field, identifier()});
+            } else if(d_pos + 1 < d_input.size() && d_input[d_pos] == '.' && d_input[d_pos + 1] == '[') {
+                ++d_pos;
+            } else {
+                return result;
+            }
+        }
+    }
+
+    segment bracket() {
+        segment s{segment::e_iterate, {}};
+        char    c = peek();
+        if(c == '"') {
+            s.kind = segment::e_field;
+            s.name = quoted();
+        } else if(c >= '0' && c <= '9') {
+            s.kind = segment::e_index;
+            char* end;
+            s.index = strtoull(d_input.data() + d_pos, &end, 10);
+            d_pos   = end - d_input.data();
+        } else if(c != ']') {
+            fail("expected an index, a string or ']'");
+        }
+        expect(']');
+        return s;
+    }
+
+    condition parse_or() {
+        auto first = parse_and();
+        if(peek() != 'o') {
+            return first;
+        }
+
+        condition c;
+        c.kind = condition::e_or;
+        c.terms.push_back(move(first));
+        while(accept_word("or")) {
+            c.terms.push_back(parse_and());
+        }
+        return c;
+    }
+
+    condition parse_and() {
+        auto first = parse_comparison();
+        if(peek() != 'a') {
+            return first;
+        }
+
+        condition c;
+        c.kind = condition::e_and;
+        c.terms.push_back(move(first));
+        while(accept_word("and")) {
+            c.terms.push_back(parse_comparison());
+        }
+        return c;
+    }
+
+    condition parse_comparison() {
+        if(accept('(')) {
+            auto c = parse_or();
+            expect(')');
+            return c;
+        }
+
+        condition c;
+        c.lhs = parse_operand();
+
+        static const pair<string_view, condition::kind_t> ops[] = {
+            {"==", condition::e_eq},
+            {"!=", condition::e_ne},
+            {"<=", condition::e_le},
+            {">=", condition::e_ge},
+            {"<", condition::e_lt},
+            {">", condition::e_gt},
+        };
+
+        skip_whitespace();
+        for(auto&& [text, kind] : ops) {
+            if(d_input.substr(d_pos, text.size()) == text) {
+                d_pos += text.size();
+                c.kind = kind;
+                c.rhs  = parse_operand();
+                break;
+            }
+        }
+        return c;
+    }
+
+    operand parse_operand() {
+        operand o;
+        char    c = peek();
+        if(c == '.') {
+            o.is_path = true;
+            o.steps   = parse_path();
+        } else if(c == '"') {
+            o.literal = quoted();
+        } else if(accept_word("true")) {
+            o.literal = true;
+        } else if(accept_word("false")) {
+            o.literal = false;
+        } else if(accept_word("null")) {
+            o.literal = none{};
+        } else if(c == '-' || (c >= '0' && c <= '9')) {
+            char* end;
+            o.literal = strtod(d_input.data() + d_pos, &end);
+            d_pos     = end - d_input.data();
+        } else {
+            fail("expected a path or a literal");
+        }
+        return o;
+    }
+
+    string_view d_input;
+    size_t      d_pos{0};
+};
+
+optional<double> as_number(const scalar_t& v) {
+    if(auto i = get_if<int64_t>(&v)) {
+        return static_cast<double>(*i);
+    } else if(auto u = get_if<uint64_t>(&v)) {
+        return static_cast<double>(*u);
+    } else if(auto d = get_if<double>(&v)) {
+        return *d;
+    }
+    return nullopt;
+}
+
+// the first value a segment yields, if any
+const tree* step(const segment& s, const tree& t) {
+    switch(s.kind) {
+    case segment::e_field:
+        return t.kind == tree::e_mapping ? t.find(s.name) : nullptr;
+    case segment::e_index:
+        return t.kind == tree::e_sequence && s.index < t.items.size() ? &t.items[s.index] : nullptr;
+    default:
+        if(!t.items.empty()) {
+            return &t.items.front();
+        }
+        return t.members.empty() ? nullptr : &t.members.front().second;
+    }
+}
+
+const tree* first(const path& steps, const tree& t) {
+    const tree* current = &t;
+    for(auto it = steps.begin(); current && it != steps.end(); ++it) {
+        current = step(*it, *current);
+    }
+    return current;
+}
+
+template <typename F>
+void each(const path& steps, size_t i, const tree& t, F&& f) {
+    if(i == steps.size()) {
+        f(t);
+        return;
+    }
+
+    auto& s = steps[i];
+    if(s.kind == segment::e_iterate) {
+        for(auto&& item : t.items) {
+            each(steps, i + 1, item, f);
+        }
+        for(auto&& m : t.members) {
+            each(steps, i + 1, m.second, f);
+        }
+    } else if(auto next = step(s, t)) {
+        each(steps, i + 1, *next, f);
+    }
+}
+
+scalar_t value_of(const operand& o, const tree& t) {
+    if(!o.is_path) {
+        return o.literal;
+    }
+    auto v = first(o.steps, t);
+    return v && v->kind == tree::e_scalar ? v->value : scalar_t{none{}};
+}
+
+// -1, 0 or 1, or nullopt if the values are not comparable
+optional<int> compare(const scalar_t& a, const scalar_t& b) {
+    auto x = as_number(a);
+    auto y = as_number(b);
+    if(x && y) {
+        return *x < *y ? -1 : (*x > *y ? 1 : 0);
+    }
+    if(a.index() != b.index()) {
+        return nullopt;
+    }
+    if(auto s = get_if<string>(&a)) {
+        return s->compare(get<string>(b)) < 0 ? -1 : (*s == get<string>(b) ? 0 : 1);
+    }
+    if(auto p = get_if<bool>(&a)) {
+        return static_cast<int>(*p) - static_cast<int>(get<bool>(b));
+    }
+    return 0;
+}
+
+bool truthy(const scalar_t& v) {
+    return !holds_alternative<none>(v) && !(holds_alternative<bool>(v) && !get<bool>(v));
+}
+
+bool holds(const condition& c, const tree& t) {
+    switch(c.kind) {
+    case condition::e_truthy:
+        if(c.lhs.is_path) {
+            auto v = first(c.lhs.steps, t);
+            return v && (v->kind != tree::e_scalar || truthy(v->value));
+        }
+        return truthy(c.lhs.literal);
+    case condition::e_and:
+        for(auto&& term : c.terms) {
+            if(!holds(term, t)) {
+                return false;
+            }
+        }
+        return true;
+    case condition::e_or:
+        for(auto&& term : c.terms) {
+            if(holds(term, t)) {
+                return true;
+            }
+        }
+        return false;
+    default:
+        break;
+    }
+
+    auto r = compare(value_of(c.lhs, t), value_of(c.rhs, t));
+    switch(c.kind) {
+    case condition::e_eq:
+        return r && *r == 0;
+    case condition::e_ne:
+        return !r || *r != 0;
+    case condition::e_lt:
+        return r && *r < 0;
+    case condition::e_le:
+        return r && *r <= 0;
+    case condition::e_gt:
+        return r && *r > 0;
+    default:
+        return r && *r >= 0;
+    }
+}
+
+} // namespace
+
+struct query::program {
+    path          stream;
+    vector<stage> rest;
+};
+
+query::query()
+  : d_program(make_unique<program>()) {
+}
+
+query::query(query&&) noexcept = default;
+query& query::operator=(query&&) noexcept = default;
+query::~query()                           = default;
+
+results::result<query> query::compile(string_view expression) {
+    try {
+        auto stages = query_parser(expression).parse();
+
+        query q;
+        auto  it = stages.begin();
+        for(; it != stages.end() && it->kind == stage::e_path; ++it) {
+            q.d_program->stream.insert(q.d_program->stream.end(), it->steps.begin(), it->steps.end());
+        }
+        q.d_program->rest.assign(make_move_iterator(it), make_move_iterator(stages.end()));
+        return results::make_ok<query>(move(q));
+    } catch(const std::exception& e) {
+        return results::make_err<query>(e.what());
+    }
+}
+
+class query_visitor::impl {
+  public:
+    impl(const query& q, ostream& out, bool compact)
+      : d_program(*q.d_program)
+      , d_out(out)
+      , d_compact(compact) {
+    }
+
+    template <typename E, typename F>
+    void value(const string_view* key, bool container, E&& forward_event, F&& open_event) {
+        if(d_capturing) {
+            forward_event(sink());
+            d_capture_depth += container ? 1 : 0;
+            return;
+        }
+
+        bool matched = position_matches(key);
+        if(matched && d_stack.size() == d_program.stream.size()) {
+            begin_capture();
+            open_event(sink());
+            if(container) {
+                d_capture_depth = 1;
+            } else {
+                end_capture();
+            }
+        } else if(container) {
+            d_stack.push_back({matched, 0});
+        }
+    }
+
+    void pop() {
+        if(!d_capturing) {
+            d_stack.pop_back();
+            return;
+        }
+
+        sink().pop();
+        if(--d_capture_depth == 0) {
+            end_capture();
+        }
+    }
+
+  private:
+    struct frame {
+        bool   matched;
+        size_t index;
+    };
+
+    bool position_matches(const string_view* key) {
+        if(d_stack.empty()) {
+            return true;
+        }
+
+        auto& parent = d_stack.back();
+        auto  index  = parent.index++;
+        if(!parent.matched) {
+            return false;
+        }
+
+        auto& s = d_program.stream[d_stack.size() - 1];
+        switch(s.kind) {
+        case segment::e_field:
+            return key && *key == s.name;
+        case segment::e_index:
+            return !key && index == s.index;
+        default:
+            return true;
+        }
+    }
+
+    visitor& sink() {
+        if(d_program.rest.empty()) {
+            return *d_writer;
+        }
+        return d_buffer;
+    }
+
+    void begin_capture() {
+        d_capturing = true;
+        if(d_program.rest.empty()) {
+            d_writer.emplace(d_out, d_compact);
+        }
+    }
+
+    void end_capture() {
+        d_capturing = false;
+        if(d_program.rest.empty()) {
+            d_writer.reset();
+            d_out.put('\n');
+        } else {
+            run(0, d_buffer.collect());
+        }
+    }
+
+    void run(size_t i, const tree& t) {
+        if(i == d_program.rest.size()) {
+            {
+                json_writer w(d_out, d_compact);
+                replay(t, w);
+            }
+            d_out.put('\n');
+            return;
+        }
+
+        auto& s = d_program.rest[i];
+        switch(s.kind) {
+        case stage::e_path:
+            each(s.steps, 0, t, [this, i](const tree& r) { run(i + 1, r); });
+            break;
+        case stage::e_select:
+            if(holds(s.test, t)) {
+                run(i + 1, t);
+            }
+            break;
+        case stage::e_object: {
+            tree result;
+            result.kind = tree::e_mapping;
+            for(auto&& f : s.fields) {
+                auto v = first(f.steps, t);
+                result.members.emplace_back(f.name, v ? *v : tree{});
+            }
+            run(i + 1, result);
+        } break;
+        }
+    }
+
+    const query::program& d_program;
+    ostream&              d_out;
+    bool                  d_compact;
+
+    vector<frame>         d_stack;
+    bool                  d_capturing{false};
+    size_t                d_capture_depth{0};
+    optional<json_writer> d_writer;
+    tree_builder          d_buffer;
+};
+
+query_visitor::query_visitor(const query& q, ostream& out, bool compact)
+  : d_pimpl(make_unique<impl>(q, out, compact)) {
+}
+
+query_visitor::~query_visitor() {
+}
+
+void query_visitor::scalar(scalar_t v) {
+    d_pimpl->value(
+        nullptr, false,
+        [&v](visitor& s) { s.scalar(move(v)); },
+        [&v](visitor& s) { s.scalar(move(v)); });
+}
+
+void query_visitor::scalar(string_view key, scalar_t v) {
+    d_pimpl->value(
+        &key, false,
+        [&](visitor& s) { s.scalar(key, move(v)); },
+        [&v](visitor& s) { s.scalar(move(v)); });
+}
+
+void query_visitor::number(raw_number n) {
+    d_pimpl->value(
+        nullptr, false,
+        [n](visitor& s) { s.number(n); },
+        [n](visitor& s) { s.number(n); });
+}
+
+void query_visitor::number(string_view key, raw_number n) {
+    d_pimpl->value(
+        &key, false,
+        [&key, n](visitor& s) { s.number(key, n); },
+        [n](visitor& s) { s.number(n); });
+}
+
+void query_visitor::push_sequence() {
+    d_pimpl->value(
+        nullptr, true,
+        [](visitor& s) { s.push_sequence(); },
+        [](visitor& s) { s.push_sequence(); });
+}
+
+void query_visitor::push_sequence(string_view key) {
+    d_pimpl->value(
+        &key, true,
+        [&key](visitor& s) { s.push_sequence(key); },
+        [](visitor& s) { s.push_sequence(); });
+}
+
+void query_visitor::push_mapping() {
+    d_pimpl->value(
+        nullptr, true,
+        [](visitor& s) { s.push_mapping(); },
+        [](visitor& s) { s.push_mapping(); });
+}
+
+void query_visitor::push_mapping(string_view key) {
+    d_pimpl->value(
+        &key, true,
+        [&key](visitor& s) { s.push_mapping(key); },
+        [](visitor& s) { s.push_mapping(); });
+}
+
+void query_visitor::pop() {
+    d_pimpl->pop();
+}
+
+maybe_error filter(istream& input, const query& q, ostream& out, bool compact) {
+    query_visitor v(q, out, compact);
+    return load(input, v);
+}
+
+maybe_error filter(string_view input, const query& q, ostream& out, bool compact) {
+    query_visitor v(q, out, compact);
+    return load(input, v);
+}
+
+} // namespace kjson
@@ -0,0 +1,62 @@
+#include "reader.hh"
+#include "parser.hh"
+#include "view_buffer.hh"
+#include <istream>
+
+namespace kjson {
+
+using namespace std;
+
+class reader::impl {
+  public:
+    impl(const limits& l, pmr::memory_resource* resource)
+      : d_limits(l)
+      , d_buffers(resource) {
+    }
+
+    maybe_error load(istream& input, visitor& v) {
+        return parse(input, v, d_buffers, d_limits);
+    }
+
+    maybe_error load(string_view input, visitor& v) {
+        d_view.reset(input);
+        return parse(d_view, v, d_buffers, d_limits);
+    }
+
+  private:
+    limits        d_limits;
+    parse_buffers d_buffers;
+    view_buffer   d_view{{}};
+};
+
+reader::reader(pmr::memory_resource* resource)
+  : reader(limits{}, resource) {
+}
+
+reader::reader(const limits& l, pmr::memory_resource* resource)
+  : d_pimpl(make_unique<impl>(l, resource)) {
+}
+
+reader::reader(reader&&) noexcept = default;
+reader& reader::operator=(reader&&) noexcept = default;
+reader::~reader()                            = default;
+
+result reader::load(istream& input) {
+    to_composite v;
+    return load(input, v).map([&v](auto) { return v.collect(); });
+}
+
+result reader::load(string_view input) {
+    to_composite v;
+    return load(input, v).map([&v](auto) { return v.collect(); });
+}
+
+maybe_error reader::load(istream& input, visitor& v) {
+    return d_pimpl->load(input, v);
+}
+
+maybe_error reader::load(string_view input, visitor& v) {
+    return d_pimpl->load(input, v);
+}
+
+} // namespace kjson
@@ -0,0 +1,264 @@
+#include "json.hh"
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+constexpr size_t chunk_size = 64 * 1024;
+
+bool is_scalar(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '-' || c == '+' || c == '.';
+}
+
+// Copies tokens from the input while checking the structure, so that dropping
+// whitespace can never merge two values; the tokens themselves are not validated.
+class reformatter {
+  public:
+    reformatter(ostream& out, bool pretty, size_t indent)
+      : d_out(out)
+      , d_pretty(pretty)
+      , d_indent(indent) {
+        d_buffer.reserve(chunk_size + 256);
+    }
+
+    void feed(string_view input) {
+        const char* p   = input.data();
+        const char* end = p + input.size();
+
+        while(p != end) {
+            if(d_in_string) {
+                p = string_run(p, end);
+            } else if(d_in_scalar) {
+                auto q = p;
+                while(q != end && is_scalar(*q)) {
+                    ++q;
+                }
+                write(p, q);
+                d_in_scalar = q == end;
+                p           = q;
+            } else {
+                token(*p++);
+            }
+        }
+
+        if(d_buffer.size() >= chunk_size) {
+            flush();
+        }
+    }
+
+    void finish() {
+        if(d_in_string) {
+            throw invalid_argument("unterminated string");
+        }
+        if(d_expect != e_end) {
+            throw invalid_argument("unexpected end of input");
+        }
+        flush();
+    }
+
+  private:
+    enum expect_t {
+        e_value,
+        e_first_value,
+        e_key,
+        e_first_key,
+        e_colon,
+        e_next,
+        e_end,
+    };
+
+    const char* string_run(const char* p, const char* end) {
+        if(d_escape) {
+            d_buffer.push_back(*p++);
+            d_escape = false;
+            return p;
+        }
+
+        auto q = p;
+        while(q != end && *q != '"' && *q != '\\') {
+            ++q;
+        }
+        write(p, q);
+
+        if(q != end) {
+            d_buffer.push_back(*q);
+            d_escape    = *q == '\\';
+            d_in_string = *q != '"';
+            ++q;
+        }
+        return q;
+    }
+
+    void token(char c) {
+        switch(c) {
+        case ' ':
+        case '\n':
+        case '\r':
+        case '\t':
+            return;
+        case '"':
+            if(d_expect == e_key || d_expect == e_first_key) {
+                begin();
+                d_expect = e_colon;
+            } else {
+                value();
+            }
+            d_buffer.push_back(c);
+            d_in_string = true;
+            return;
+        case '{':
+        case '[':
+            value();
+            d_buffer.push_back(c);
+            d_stack.push_back(c == '{' ? '}' : ']');
+            d_expect  = c == '{' ? e_first_key : e_first_value;
+            d_pending = d_pretty;
+            return;
+        case '}':
+        case ']':
+            close(c);
+            return;
+        case ':':
+            if(d_expect != e_colon) {
+                throw invalid_argument("unexpected ':'");
+            }
+            d_buffer.append(d_pretty ? ": " : ":");
+            d_expect = e_value;
+            return;
+        case ',':
+            if(d_expect != e_next) {
+                throw invalid_argument("unexpected ','");
+            }
+            d_buffer.push_back(',');
+            d_expect = d_stack.back() == '}' ? e_key : e_value;
+            newline(d_stack.size());
+            return;
+        default:
+            if(!is_scalar(c)) {
+                throw invalid_argument(string("unexpected char ") + c);
+            }
+            value();
+            d_buffer.push_back(c);
+            d_in_scalar = true;
+            return;
+        }
+    }
+
+    void begin() {
+        if(d_pending) {
+            d_pending = false;
+            newline(d_stack.size());
+        }
+    }
+
+    void value() {
+        if(d_expect != e_value && d_expect != e_first_value) {
+            throw invalid_argument("unexpected value");
+        }
+        begin();
+        d_expect = d_stack.empty() ? e_end : e_next;
+    }
+
+    void close(char c) {
+        bool empty = d_expect == (c == '}' ? e_first_key : e_first_value);
+        if((!empty && d_expect != e_next) || d_stack.empty() || d_stack.back() != c) {
+            throw invalid_argument(string("unexpected '") + c + "'");
+        }
+
+        d_stack.pop_back();
+        if(!empty) {
+            newline(d_stack.size());
+        }
+        d_pending = false;
+        d_buffer.push_back(c);
+        d_expect = d_stack.empty() ? e_end : e_next;
+    }
+
+    void newline(size_t depth) {
+        if(d_pretty) {
+            d_buffer.push_back('\n');
+            d_buffer.append(depth * d_indent, ' ');
+        }
+    }
+
+    void write(const char* first, const char* last) {
+        d_buffer.append(first, last);
+    }
+
+    void flush() {
+        d_out.write(d_buffer.data(), d_buffer.size());
+        d_buffer.clear();
+    }
+
+    ostream&     d_out;
+    bool         d_pretty;
+    size_t       d_indent;
+    string       d_buffer;
+    vector<char> d_stack;
+    expect_t     d_expect{e_value};
+    bool         d_in_string{false};
+    bool         d_in_scalar{false};
+    bool         d_escape{false};
+    bool         d_pending{false};
+};
+
+maybe_error reformat(istream& input, ostream& out, bool pretty, size_t indent) {
+    try {
+        reformatter r(out, pretty, indent);
+        auto        buf = input.rdbuf();
+        string      chunk(chunk_size, '\0');
+
+        streamsize n;
+        while((n = buf->sgetn(&chunk[0], chunk.size())) > 0) {
+            r.feed(string_view(chunk.data(), n));
+        }
+        r.finish();
+        return maybe_error::ok(std::monostate{});
+    } catch(const std::exception& e) {
+        return maybe_error::err(e.what());
+    }
+}
+
+maybe_error reformat(string_view input, ostream& out, bool pretty, size_t indent) {
+    try {
+        reformatter r(out, pretty, indent);
+        while(!input.empty()) {
+            auto n = min(input.size(), chunk_size);
+            r.feed(input.substr(0, n));
+            input.remove_prefix(n);
+        }
+        r.finish();
+        return maybe_error::ok(std::monostate{});
+    } catch(const std::exception& e) {
+        return maybe_error::err(e.what());
+    }
+}
+
+} // namespace
+
+maybe_error minify(istream& input, ostream& out) {
+    return reformat(input, out, false, 0);
+}
+
+maybe_error minify(string_view input, ostream& out) {
+    return reformat(input, out, false, 0);
+}
+
+maybe_error prettify(istream& input, ostream& out, size_t indent) {
+    return reformat(input, out, true, indent);
+}
+
+maybe_error prettify(string_view input, ostream& out, size_t indent) {
+    return reformat(input, out, true, indent);
+}
+
+} // namespace kjson
@@ -0,0 +1,501 @@
+#include "schema.hh"
+#include "tree.hh"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <memory>
+#include <utility>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+bool is_integral(double d) {
+    return isfinite(d) && floor(d) == d;
+}
+
+optional<double> as_number(const scalar_t& v) {
+    if(auto i = get_if<int64_t>(&v)) {
+        return static_cast<double>(*i);
+    } else if(auto u = get_if<uint64_t>(&v)) {
+        return static_cast<double>(*u);
+    } else if(auto d = get_if<double>(&v)) {
+        return *d;
+    }
+    return nullopt;
+}
+
+bool equal(const scalar_t& a, const scalar_t& b) {
+    auto x = as_number(a);
+    auto y = as_number(b);
+    if(x || y) {
+        return x && y && *x == *y;
+    }
+    if(a.index() != b.index()) {
+        return false;
+    }
+    if(auto s = get_if<string>(&a)) {
+        return *s == get<string>(b);
+    } else if(auto t = get_if<bool>(&a)) {
+        return *t == get<bool>(b);
+    }
+    return true;
+}
+
+size_t code_points(string_view s) {
+    return count_if(s.begin(), s.end(), [](char c) { return (static_cast<unsigned char>(c) & 0xc0) != 0x80; });
+}
+
+string describe(const scalar_t& v) {
+    switch(v.index()) {
+    case 0:
+        return "null";
+    case 1:
+        return "a boolean";
+    case 5:
+        return "a string";
+    default:
+        return "a number";
+    }
+}
+
+} // namespace
+
+class schema_compiler {
+  public:
+    explicit schema_compiler(schema& s)
+      : d_schema(s) {
+    }
+
+    size_t compile(const tree& d) {
+        if(d.kind == tree::e_scalar && get_if<bool>(&d.value) && get<bool>(d.value)) {
+            return schema::any;
+        }
+        if(d.kind != tree::e_mapping) {
+            throw schema_error("a schema must be an object");
+        }
+
+        auto index = d_schema.d_nodes.size();
+        d_schema.d_nodes.emplace_back();
+
+        schema::node n;
+        for(auto&& [keyword, value] : d.members) {
+            if(keyword == "type") {
+                n.types = types(value);
+            } else if(keyword == "enum") {
+                if(value.kind != tree::e_sequence) {
+                    throw schema_error("enum must be an array");
+                }
+                for(auto&& item : value.items) {
+                    if(item.kind != tree::e_scalar) {
+                        throw schema_error("only scalar enum values are supported");
+                    }
+                    n.enumeration.push_back(item.value);
+                }
+                n.has_enum = true;
+            } else if(keyword == "minimum") {
+                n.minimum = number(keyword, value);
+            } else if(keyword == "maximum") {
+                n.maximum = number(keyword, value);
+            } else if(keyword == "exclusiveMinimum") {
+                n.exclusive_minimum = number(keyword, value);
+            } else if(keyword == "exclusiveMaximum") {
+                n.exclusive_maximum = number(keyword, value);
+            } else if(keyword == "minLength") {
+                n.min_length = count(keyword, value);
+            } else if(keyword == "maxLength") {
+                n.max_length = count(keyword, value);
+            } else if(keyword == "minItems") {
+                n.min_items = count(keyword, value);
+            } else if(keyword == "maxItems") {
+                n.max_items = count(keyword, value);
+            } else if(keyword == "items") {
+                n.items = compile(value);
+            } else if(keyword == "properties") {
+                if(value.kind != tree::e_mapping) {
+                    throw schema_error("properties must be an object");
+                }
+                for(auto&& [name, sub] : value.members) {
+                    property(n, name).node = compile(sub);
+                }
+            } else if(keyword == "required") {
+                if(value.kind != tree::e_sequence) {
+                    throw schema_error("required must be an array");
+                }
+                for(auto&& item : value.items) {
+                    auto name = get_if<string>(&item.value);
+                    if(item.kind != tree::e_scalar || !name) {
+                        throw schema_error("required must list strings");
+                    }
+                    auto& p = property(n, *name);
+                    n.required += p.required ? 0 : 1;
+                    p.required = true;
+                }
+            }
+        }
+
+        sort(n.properties.begin(), n.properties.end(), [](auto&& a, auto&& b) { return a.name < b.name; });
+        d_schema.d_nodes[index] = move(n);
+        return index;
+    }
+
+  private:
+    uint8_t types(const tree& d) {
+        if(d.kind == tree::e_sequence) {
+            uint8_t result = 0;
+            for(auto&& item : d.items) {
+                result |= types(item);
+            }
+            return result;
+        }
+
+        auto name = get_if<string>(&d.value);
+        if(d.kind != tree::e_scalar || !name) {
+            throw schema_error("type must be a string or an array of strings");
+        }
+
+        if(*name == "null") {
+            return schema::e_null;
+        } else if(*name == "boolean") {
+            return schema::e_boolean;
+        } else if(*name == "integer") {
+            return schema::e_integer;
+        } else if(*name == "number") {
+            return schema::e_number | schema::e_integer;
+        } else if(*name == "string") {
+            return schema::e_string;
+        } else if(*name == "array") {
+            return schema::e_array;
+        } else if(*name == "object") {
+            return schema::e_object;
+        }
+        throw schema_error("unknown type " + *name);
+    }
+
+    double number(const string& keyword, const tree& d) {
+        auto n = d.kind == tree::e_scalar ? as_number(d.value) : nullopt;
+        if(!n) {
+            throw schema_error(keyword + " must be a number");
+        }
+        return *n;
+    }
+
+    size_t count(const string& keyword, const tree& d) {
+        auto n = number(keyword, d);
+        if(n < 0 || !is_integral(n)) {
+            throw schema_error(keyword + " must be a non-negative integer");
+        }
+        return static_cast<size_t>(n);
+    }
+
+    schema::property& property(schema::node& n, const string& name) {
+        for(auto&& p : n.properties) {
+            if(p.name == name) {
+                return p;
+            }
+        }
+        return n.properties.emplace_back(schema::property{name, schema::any, false});
+    }
+
+    schema& d_schema;
+};
+
+results::result<schema> schema::compile(const document& definition) {
+    try {
+        tree_builder b;
+        walk(definition, b);
+
+        schema s;
+        schema_compiler(s).compile(b.collect());
+        return results::make_ok<schema>(move(s));
+    } catch(const std::exception& e) {
+        return results::make_err<schema>(e.what());
+    }
+}
+
+results::result<schema> schema::parse(string_view definition) {
+    tree_builder b;
+    auto               loaded = load(definition, b);
+    if(loaded.is_err()) {
+        return results::make_err<schema>("invalid schema json");
+    }
+
+    try {
+        schema s;
+        schema_compiler(s).compile(b.collect());
+        return results::make_ok<schema>(move(s));
+    } catch(const std::exception& e) {
+        return results::make_err<schema>(e.what());
+    }
+}
+
+schema_validator::schema_validator(const schema& s)
+  : d_schema(s)
+  , d_next(nullptr) {
+}
+
+schema_validator::schema_validator(const schema& s, visitor& next)
+  : d_schema(s)
+  , d_next(&next) {
+}
+
+void schema_validator::scalar(scalar_t v) {
+    d_key = nullptr;
+    check_scalar(enter(nullptr), v);
+    if(d_next) {
+        d_next->scalar(move(v));
+    }
+}
+
+void schema_validator::scalar(string_view key, scalar_t v) {
+    d_key = &key;
+    check_scalar(enter(&key), v);
+    if(d_next) {
+        d_next->scalar(key, move(v));
+    }
+}
+
+void schema_validator::push_sequence() {
+    d_key = nullptr;
+    push(enter(nullptr), false);
+    if(d_next) {
+        d_next->push_sequence();
+    }
+}
+
+void schema_validator::push_sequence(string_view key) {
+    d_key = &key;
+    push(enter(&key), false);
+    if(d_next) {
+        d_next->push_sequence(key);
+    }
+}
+
+void schema_validator::push_mapping() {
+    d_key = nullptr;
+    push(enter(nullptr), true);
+    if(d_next) {
+        d_next->push_mapping();
+    }
+}
+
+void schema_validator::push_mapping(string_view key) {
+    d_key = &key;
+    push(enter(&key), true);
+    if(d_next) {
+        d_next->push_mapping(key);
+    }
+}
+
+void schema_validator::pop() {
+    d_key   = nullptr;
+    auto& f = d_stack.back();
+    if(f.node != schema::any) {
+        auto& n = d_schema.d_nodes[f.node];
+        if(f.mapping && f.required < n.required) {
+            for(size_t i = 0; i < n.properties.size(); ++i) {
+                if(n.properties[i].required && !f.seen[i]) {
+                    fail("missing required property " + n.properties[i].name, true);
+                }
+            }
+        }
+        if(!f.mapping && n.min_items && f.count < *n.min_items) {
+            fail("expected at least " + to_string(*n.min_items) + " items", true);
+        }
+        if(!f.mapping && n.max_items && f.count > *n.max_items) {
+            fail("expected at most " + to_string(*n.max_items) + " items", true);
+        }
+    }
+    d_keys.resize(f.key_begin);
+    d_stack.pop_back();
+
+    if(d_next) {
+        d_next->pop();
+    }
+}
+
+void schema_validator::number(raw_number n) {
+    d_key = nullptr;
+    check_scalar(enter(nullptr), n.value());
+    if(d_next) {
+        d_next->number(n);
+    }
+}
+
+void schema_validator::number(string_view key, raw_number n) {
+    d_key = &key;
+    check_scalar(enter(&key), n.value());
+    if(d_next) {
+        d_next->number(key, n);
+    }
+}
+
+bool schema_validator::expect_binary() {
+    return d_next && d_next->expect_binary();
+}
+
+bool schema_validator::expect_binary(string_view key) {
+    return d_next && d_next->expect_binary(key);
+}
+
+void schema_validator::binary(const byte* data, size_t size) {
+    d_key = nullptr;
+    check_scalar(enter(nullptr), string(reinterpret_cast<const char*>(data), size));
+    if(d_next) {
+        d_next->binary(data, size);
+    }
+}
+
+void schema_validator::binary(string_view key, const byte* data, size_t size) {
+    d_key = &key;
+    check_scalar(enter(&key), string(reinterpret_cast<const char*>(data), size));
+    if(d_next) {
+        d_next->binary(key, data, size);
+    }
+}
+
+size_t schema_validator::enter(const string_view* key) {
+    if(d_stack.empty()) {
+        return d_schema.d_nodes.empty() ? schema::any : 0;
+    }
+
+    auto& f = d_stack.back();
+    ++f.count;
+    if(f.node == schema::any) {
+        return schema::any;
+    }
+
+    auto& n = d_schema.d_nodes[f.node];
+    if(!f.mapping) {
+        return n.items;
+    }
+
+    auto it = lower_bound(n.properties.begin(), n.properties.end(), *key, [](auto&& p, string_view k) { return p.name < k; });
+    if(it == n.properties.end() || it->name != *key) {
+        return schema::any;
+    }
+
+    auto i = static_cast<size_t>(it - n.properties.begin());
+    if(it->required && !f.seen[i]) {
+        ++f.required;
+    }
+    f.seen[i] = true;
+    return it->node;
+}
+
+void schema_validator::check_scalar(size_t node, const scalar_t& v) {
+    if(node == schema::any) {
+        return;
+    }
+    auto& n = d_schema.d_nodes[node];
+
+    uint8_t type = 0;
+    auto    num  = as_number(v);
+    switch(v.index()) {
+    case 0:
+        type = schema::e_null;
+        break;
+    case 1:
+        type = schema::e_boolean;
+        break;
+    case 5:
+        type = schema::e_string;
+        break;
+    default:
+        type = is_integral(*num) ? schema::e_integer : schema::e_number;
+        break;
+    }
+    if(!(n.types & type)) {
+        fail("unexpected " + describe(v));
+    }
+
+    if(num) {
+        if((n.minimum && *num < *n.minimum) || (n.exclusive_minimum && *num <= *n.exclusive_minimum)) {
+            fail("number below minimum");
+        }
+        if((n.maximum && *num > *n.maximum) || (n.exclusive_maximum && *num >= *n.exclusive_maximum)) {
+            fail("number above maximum");
+        }
+    }
+
+    if(auto s = get_if<string>(&v); s && (n.min_length || n.max_length)) {
+        auto length = code_points(*s);
+        if(n.min_length && length < *n.min_length) {
+            fail("string shorter than " + to_string(*n.min_length));
+        }
+        if(n.max_length && length > *n.max_length) {
+            fail("string longer than " + to_string(*n.max_length));
+        }
+    }
+
+    if(n.has_enum && none_of(n.enumeration.begin(), n.enumeration.end(), [&v](auto&& e) { return equal(e, v); })) {
+        fail("value not in enum");
+    }
+}
+
+void schema_validator::push(size_t node, bool mapping) {
+    if(node != schema::any) {
+        auto& n = d_schema.d_nodes[node];
+        if(!(n.types & (mapping ? schema::e_object : schema::e_array))) {
+            fail(mapping ? "unexpected object" : "unexpected array");
+        }
+        if(n.has_enum) {
+            fail("value not in enum");
+        }
+    }
+
+    frame f{node, mapping, 0, 0, {}, d_keys.size(), 0, string::npos};
+    if(d_key) {
+        d_keys += *d_key;
+        f.key_size = d_key->size();
+    } else if(!d_stack.empty() && !d_stack.back().mapping) {
+        f.index = d_stack.back().count - 1;
+    }
+    if(mapping && node != schema::any) {
+        f.seen.resize(d_schema.d_nodes[node].properties.size());
+    }
+    d_stack.push_back(move(f));
+}
+
+string schema_validator::segment() const {
+    if(d_key) {
+        return "/" + string(*d_key);
+    } else if(!d_stack.empty() && !d_stack.back().mapping) {
+        return "/" + to_string(d_stack.back().count - 1);
+    }
+    return {};
+}
+
+string schema_validator::segment(const frame& f) const {
+    if(f.index != string::npos) {
+        return "/" + to_string(f.index);
+    } else if(f.key_size || &f != &d_stack.front()) {
+        return "/" + d_keys.substr(f.key_begin, f.key_size);
+    }
+    return {};
+}
+
+void schema_validator::fail(const string& what, bool in_container) const {
+    string where;
+    for(auto&& f : d_stack) {
+        where += segment(f);
+    }
+    if(!in_container) {
+        where += segment();
+    }
+    throw schema_error((where.empty() ? string("/") : where) + ": " + what);
+}
+
+maybe_error validate(istream& input, const schema& s) {
+    schema_validator v(s);
+    return load(input, v);
+}
+
+maybe_error validate(string_view input, const schema& s) {
+    schema_validator v(s);
+    return load(input, v);
+}
+
+} // namespace kjson
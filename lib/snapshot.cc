@@ -0,0 +1,511 @@
+#include "snapshot.hh"
+#include "parser.hh"
+#include "visitor.hh"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+using type_t = snapshot::value::type_t;
+
+constexpr char     magic[8]   = {'K', 'J', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr uint32_t version    = 1;
+constexpr uint32_t byte_order = 0x01020304;
+
+struct header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint64_t root;
+    uint64_t pool;
+    uint64_t pool_size;
+};
+
+// scalars are stored in the payload, strings refer to the pool and containers to
+// an array of nodes (sequences) or entries (mappings)
+struct node {
+    uint32_t type;
+    uint32_t size;
+    uint64_t payload;
+};
+
+struct entry {
+    uint64_t key;
+    uint32_t key_size;
+    uint32_t padding;
+    node     value;
+};
+
+static_assert(sizeof(header) == 48, "unexpected header layout");
+static_assert(sizeof(node) == 16, "unexpected node layout");
+static_assert(sizeof(entry) == 32, "unexpected entry layout");
+static_assert(offsetof(entry, value) == 16, "unexpected entry layout");
+
+template <typename T>
+T read(const char* p) {
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+uint64_t align(uint64_t offset) {
+    return (offset + 7) & ~uint64_t{7};
+}
+
+uint32_t checked_size(size_t size) {
+    if(size > numeric_limits<uint32_t>::max()) {
+        throw snapshot_error("value too large for a snapshot");
+    }
+    return static_cast<uint32_t>(size);
+}
+
+class snapshot_writer {
+  public:
+    snapshot_writer() {
+        d_tree.resize(sizeof(header) + sizeof(node));
+    }
+
+    string finish(const document& data) {
+        write(sizeof(header), data);
+
+        header h{};
+        memcpy(h.magic, magic, sizeof(magic));
+        h.version    = version;
+        h.byte_order = byte_order;
+        h.root       = sizeof(header);
+        h.pool       = align(d_tree.size());
+        h.pool_size  = d_pool.size();
+        h.file_size  = h.pool + h.pool_size;
+
+        d_tree.resize(h.pool);
+        d_tree += d_pool;
+        memcpy(&d_tree[0], &h, sizeof(h));
+
+        return move(d_tree);
+    }
+
+  private:
+    class node_writer {
+      public:
+        node_writer(snapshot_writer& w, uint64_t at)
+          : d_writer(w)
+          , d_at(at) {
+        }
+
+        template <typename T>
+        void operator()(T&& v) {
+            using U = decay_t<T>;
+
+            if constexpr(is_void_v<U> || is_empty_v<U>) {
+                put(type_t::e_none, 0, 0);
+            } else if constexpr(is_same_v<U, bool>) {
+                put(type_t::e_bool, 0, v ? 1 : 0);
+            } else if constexpr(is_integral_v<U> && is_signed_v<U>) {
+                put(type_t::e_int, 0, static_cast<uint64_t>(static_cast<int64_t>(v)));
+            } else if constexpr(is_integral_v<U> && is_unsigned_v<U>) {
+                put(type_t::e_uint, 0, static_cast<uint64_t>(v));
+            } else if constexpr(is_floating_point_v<U>) {
+                double   d = v;
+                uint64_t bits;
+                memcpy(&bits, &d, sizeof(bits));
+                put(type_t::e_float, 0, bits);
+            } else if constexpr(is_convertible_v<U, string_view>) {
+                string_view s(v);
+                put(type_t::e_string, checked_size(s.size()), d_writer.intern(s));
+            } else {
+                throw snapshot_error("no conversion available");
+            }
+        }
+
+        void operator()(const composite::sequence& v) {
+            auto items = d_writer.allocate(v.size() * sizeof(node));
+            put(type_t::e_sequence, checked_size(v.size()), items);
+
+            for(auto&& item : v) {
+                node_writer w(d_writer, items);
+                item.visit(w);
+                items += sizeof(node);
+            }
+        }
+
+        void operator()(const composite::mapping& v) {
+            vector<pair<string_view, const document*>> members;
+            members.reserve(v.size());
+            for(auto&& kv : v) {
+                members.emplace_back(kv.first, &kv.second);
+            }
+            sort(members.begin(), members.end(), [](auto&& a, auto&& b) { return a.first < b.first; });
+
+            auto entries = d_writer.allocate(members.size() * sizeof(entry));
+            put(type_t::e_mapping, checked_size(members.size()), entries);
+
+            for(auto&& m : members) {
+                entry e{};
+                e.key      = d_writer.intern(m.first);
+                e.key_size = checked_size(m.first.size());
+                memcpy(&d_writer.d_tree[entries], &e, offsetof(entry, value));
+
+                node_writer w(d_writer, entries + offsetof(entry, value));
+                m.second->visit(w);
+                entries += sizeof(entry);
+            }
+        }
+
+      private:
+        void put(type_t type, uint32_t size, uint64_t payload) {
+            node n{static_cast<uint32_t>(type), size, payload};
+            memcpy(&d_writer.d_tree[d_at], &n, sizeof(n));
+        }
+
+        snapshot_writer& d_writer;
+        uint64_t         d_at;
+    };
+
+    void write(uint64_t at, const document& data) {
+        node_writer w(*this, at);
+        data.visit(w);
+    }
+
+    uint64_t allocate(size_t size) {
+        auto offset = align(d_tree.size());
+        d_tree.resize(offset + size);
+        return offset;
+    }
+
+    uint64_t intern(string_view s) {
+        auto it = d_strings.find(s);
+        if(it != d_strings.end()) {
+            return it->second;
+        }
+
+        auto offset = d_pool.size();
+        d_pool.append(s.data(), s.size());
+        d_strings.emplace(s, offset);
+        return offset;
+    }
+
+    string                                  d_tree;
+    string                                  d_pool;
+    unordered_map<string_view, uint64_t> d_strings;
+};
+
+bool write_all(int fd, const string& data) {
+    size_t written = 0;
+    while(written < data.size()) {
+        auto n = ::write(fd, data.data() + written, data.size() - written);
+        if(n < 0 && errno != EINTR) {
+            return false;
+        }
+        written += n < 0 ? 0 : static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+// The image goes to a temporary file that is renamed over path, so a process
+// that has the old snapshot mapped keeps reading it, and a failed write leaves
+// path untouched.
+maybe_error save_snapshot(const document& data, const string& path) {
+    try {
+        snapshot_writer w;
+        auto            image = w.finish(data);
+
+        string temp = path + ".XXXXXX";
+        int    fd   = mkstemp(&temp[0]);
+        if(fd < 0) {
+            return maybe_error::err("failed to create " + temp + ": " + strerror(errno));
+        }
+
+        // mkstemp() creates the file private to its owner, readers may be other users
+        int error = 0;
+        if(fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0 || !write_all(fd, image) || fsync(fd) != 0) {
+            error = errno;
+        }
+        if(::close(fd) != 0 && error == 0) {
+            error = errno;
+        }
+        if(error == 0 && rename(temp.c_str(), path.c_str()) != 0) {
+            error = errno;
+        }
+        if(error != 0) {
+            unlink(temp.c_str());
+            return maybe_error::err("failed to write snapshot " + path + ": " + strerror(error));
+        }
+        return maybe_error::ok(std::monostate{});
+    } catch(const std::exception& e) {
+        return maybe_error::err(e.what());
+    }
+}
+
+results::result<snapshot> open_snapshot(const string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return results::make_err<snapshot>("failed to open " + path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        ::close(fd);
+        return results::make_err<snapshot>("failed to stat " + path + ": " + strerror(errno));
+    }
+
+    auto size = static_cast<size_t>(st.st_size);
+    if(size < sizeof(header)) {
+        ::close(fd);
+        return results::make_err<snapshot>(path + " is not a snapshot");
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) {
+        return results::make_err<snapshot>("failed to map " + path + ": " + strerror(errno));
+    }
+
+    snapshot s(static_cast<const char*>(data), size);
+
+    auto h = read<header>(s.d_data);
+    if(memcmp(h.magic, magic, sizeof(magic)) != 0 ||
+       h.version != version ||
+       h.byte_order != byte_order ||
+       h.file_size != size ||
+       h.root != sizeof(header) ||
+       h.pool > size ||
+       h.pool_size > size - h.pool) {
+        return results::make_err<snapshot>(path + " is not a valid snapshot");
+    }
+
+    s.d_pool      = h.pool;
+    s.d_pool_size = h.pool_size;
+    return results::make_ok<snapshot>(move(s));
+}
+
+snapshot::snapshot(const char* data, size_t size)
+  : d_data(data)
+  , d_size(size) {
+}
+
+snapshot::snapshot(snapshot&& other) noexcept
+  : d_data(exchange(other.d_data, nullptr))
+  , d_size(exchange(other.d_size, 0))
+  , d_pool(other.d_pool)
+  , d_pool_size(other.d_pool_size) {
+}
+
+snapshot& snapshot::operator=(snapshot&& other) noexcept {
+    swap(d_data, other.d_data);
+    swap(d_size, other.d_size);
+    swap(d_pool, other.d_pool);
+    swap(d_pool_size, other.d_pool_size);
+    return *this;
+}
+
+snapshot::~snapshot() {
+    if(d_data) {
+        munmap(const_cast<char*>(d_data), d_size);
+    }
+}
+
+snapshot::value snapshot::root() const {
+    return value(*this, sizeof(header));
+}
+
+const char* snapshot::at(uint64_t offset, uint64_t size) const {
+    if(offset > d_size || size > d_size - offset) {
+        throw snapshot_error("corrupt snapshot");
+    }
+    return d_data + offset;
+}
+
+snapshot::value::value(const snapshot& owner, uint64_t offset)
+  : d_owner(&owner)
+  , d_offset(offset) {
+}
+
+snapshot::value::type_t snapshot::value::type() const {
+    auto n = read<node>(d_owner->at(d_offset, sizeof(node)));
+    if(n.type > static_cast<uint32_t>(type_t::e_mapping)) {
+        throw snapshot_error("corrupt snapshot");
+    }
+    return static_cast<type_t>(n.type);
+}
+
+void snapshot::value::expect(type_t t) const {
+    if(type() != t) {
+        throw snapshot_error("unexpected type");
+    }
+}
+
+bool snapshot::value::as_bool() const {
+    expect(type_t::e_bool);
+    return read<node>(d_owner->at(d_offset, sizeof(node))).payload != 0;
+}
+
+int64_t snapshot::value::as_int() const {
+    expect(type_t::e_int);
+    return static_cast<int64_t>(read<node>(d_owner->at(d_offset, sizeof(node))).payload);
+}
+
+uint64_t snapshot::value::as_uint() const {
+    expect(type_t::e_uint);
+    return read<node>(d_owner->at(d_offset, sizeof(node))).payload;
+}
+
+double snapshot::value::as_float() const {
+    expect(type_t::e_float);
+    auto   bits = read<node>(d_owner->at(d_offset, sizeof(node))).payload;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+string_view snapshot::value::as_string() const {
+    expect(type_t::e_string);
+    auto n = read<node>(d_owner->at(d_offset, sizeof(node)));
+    if(n.payload > d_owner->d_pool_size || n.size > d_owner->d_pool_size - n.payload) {
+        throw snapshot_error("corrupt snapshot");
+    }
+    return string_view(d_owner->d_data + d_owner->d_pool + n.payload, n.size);
+}
+
+size_t snapshot::value::size() const {
+    auto t = type();
+    if(t != type_t::e_sequence && t != type_t::e_mapping) {
+        throw snapshot_error("not a container");
+    }
+    return read<node>(d_owner->at(d_offset, sizeof(node))).size;
+}
+
+snapshot::value snapshot::value::operator[](size_t i) const {
+    auto t = type();
+    auto n = read<node>(d_owner->at(d_offset, sizeof(node)));
+    if((t != type_t::e_sequence && t != type_t::e_mapping) || i >= n.size) {
+        throw out_of_range("index out of range");
+    }
+    // items are always written after their container, so a payload that points
+    // back could make walk() loop forever
+    if(n.payload < d_offset + sizeof(node)) {
+        throw snapshot_error("corrupt snapshot");
+    }
+
+    if(t == type_t::e_sequence) {
+        return value(*d_owner, n.payload + i * sizeof(node));
+    }
+    return value(*d_owner, n.payload + i * sizeof(entry) + offsetof(entry, value));
+}
+
+string_view snapshot::value::key(size_t i) const {
+    expect(type_t::e_mapping);
+    auto n = read<node>(d_owner->at(d_offset, sizeof(node)));
+    if(i >= n.size) {
+        throw out_of_range("index out of range");
+    }
+
+    auto e = read<entry>(d_owner->at(n.payload + i * sizeof(entry), sizeof(entry)));
+    if(e.key > d_owner->d_pool_size || e.key_size > d_owner->d_pool_size - e.key) {
+        throw snapshot_error("corrupt snapshot");
+    }
+    return string_view(d_owner->d_data + d_owner->d_pool + e.key, e.key_size);
+}
+
+optional<snapshot::value> snapshot::value::find(string_view k) const {
+    size_t first = 0;
+    size_t last  = size();
+    expect(type_t::e_mapping);
+
+    while(first < last) {
+        auto mid = first + (last - first) / 2;
+        auto c   = key(mid).compare(k);
+        if(c == 0) {
+            return (*this)[mid];
+        } else if(c < 0) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return nullopt;
+}
+
+void snapshot::value::walk(visitor& v) const {
+    walk(v, nullptr);
+}
+
+void snapshot::value::walk(visitor& v, const string_view* key) const {
+    auto scalar = [&](scalar_t s) {
+        if(key) {
+            v.scalar(*key, move(s));
+        } else {
+            v.scalar(move(s));
+        }
+    };
+
+    switch(type()) {
+    case type_t::e_none:
+        scalar(none{});
+        break;
+    case type_t::e_bool:
+        scalar(as_bool());
+        break;
+    case type_t::e_int:
+        scalar(as_int());
+        break;
+    case type_t::e_uint:
+        scalar(as_uint());
+        break;
+    case type_t::e_float:
+        scalar(as_float());
+        break;
+    case type_t::e_string:
+        scalar(string(as_string()));
+        break;
+    case type_t::e_sequence:
+        if(key) {
+            v.push_sequence(*key);
+        } else {
+            v.push_sequence();
+        }
+        for(size_t i = 0, n = size(); i < n; ++i) {
+            (*this)[i].walk(v, nullptr);
+        }
+        v.pop();
+        break;
+    case type_t::e_mapping:
+        if(key) {
+            v.push_mapping(*key);
+        } else {
+            v.push_mapping();
+        }
+        for(size_t i = 0, n = size(); i < n; ++i) {
+            auto k = this->key(i);
+            (*this)[i].walk(v, &k);
+        }
+        v.pop();
+        break;
+    }
+}
+
+document snapshot::value::to_document() const {
+    to_composite v;
+    walk(v);
+    return v.collect();
+}
+
+} // namespace kjson
@@ -0,0 +1,88 @@
+#include "stats.hh"
+#include "counting_buffer.hh"
+#include "instrument.hh"
+#include "json_builder.hh"
+#include "parser.hh"
+#include "view_buffer.hh"
+#include <istream>
+
+namespace kjson {
+
+using namespace std;
+
+thread_local stats* t_stats = nullptr;
+
+namespace {
+
+// Points t_stats at s for the duration of a call and attributes the time that
+// was not spent tokenizing to building.
+class stats_scope {
+  public:
+    explicit stats_scope(stats& s)
+      : d_previous(t_stats)
+      , d_tokenize(s.tokenize)
+      , d_start(chrono::steady_clock::now()) {
+        t_stats = &s;
+    }
+
+    ~stats_scope() {
+        auto& s = *t_stats;
+        s.build += (chrono::steady_clock::now() - d_start) - (s.tokenize - d_tokenize);
+        t_stats = d_previous;
+    }
+
+  private:
+    stats*                           d_previous;
+    chrono::nanoseconds              d_tokenize;
+    chrono::steady_clock::time_point d_start;
+};
+
+} // namespace
+
+maybe_error load(istream& input, visitor& v, stats& s) {
+    if constexpr(!stats::enabled) {
+        return load(input, v);
+    }
+
+    stats_scope     scope(s);
+    counting_buffer buf(*input.rdbuf(), s.bytes);
+    return parse(buf, v);
+}
+
+maybe_error load(string_view input, visitor& v, stats& s) {
+    if constexpr(!stats::enabled) {
+        return load(input, v);
+    }
+
+    stats_scope     scope(s);
+    view_buffer     view(input);
+    counting_buffer buf(view, s.bytes);
+    return parse(buf, v);
+}
+
+result load(istream& input, stats& s) {
+    to_composite v;
+    return load(input, v, s)
+        .map([&v, &s](auto) {
+            stats_scope scope(s);
+            return v.collect();
+        });
+}
+
+result load(string_view input, stats& s) {
+    view_buffer buf(input);
+    istream     str(&buf);
+    return load(str, s);
+}
+
+void dump(const document& data, ostream& out, stats& s, bool compact) {
+    if constexpr(!stats::enabled) {
+        return dump(data, out, compact);
+    }
+
+    stats_scope  scope(s);
+    json_builder jb(out, compact);
+    data.visit(jb);
+}
+
+} // namespace kjson
@@ -0,0 +1,64 @@
+#include "allocations.hh"
+#include "instrument.hh"
+#include "stats.hh"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replacing the global allocation functions is the only way to see the
+// allocations of composite and of the caller's visitor. It lives outside of
+// libkjson so that only programs that link kjson_allocations get it.
+namespace {
+
+std::atomic<size_t> total_count{0};
+std::atomic<size_t> total_bytes{0};
+
+void* counted_allocation(size_t size, size_t alignment) {
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total_bytes.fetch_add(size, std::memory_order_relaxed);
+    kjson::record([size](kjson::stats& s) {
+        ++s.allocations;
+        s.allocated_bytes += size;
+    });
+
+    void* p = nullptr;
+    if(alignment <= alignof(max_align_t)) {
+        p = std::malloc(size ? size : 1);
+    } else if(posix_memalign(&p, alignment, size ? size : 1) != 0) {
+        p = nullptr;
+    }
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+kjson::allocation_count kjson::allocation_count::now() {
+    return {total_count.load(std::memory_order_relaxed), total_bytes.load(std::memory_order_relaxed)};
+}
+
+void* operator new(size_t size) {
+    return counted_allocation(size, alignof(max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return counted_allocation(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
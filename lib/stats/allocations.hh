@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace kjson {
+
+// Totals of the global operator new since the start of the process, on all
+// threads. Only programs that link kjson_allocations count them.
+struct allocation_count {
+    std::size_t count;
+    std::size_t bytes;
+
+    static allocation_count now();
+};
+
+} // namespace kjson
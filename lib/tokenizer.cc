@@ -1,10 +1,13 @@
 #include "tokenizer.hh"
+#include "base64.hh"
+#include "instrument.hh"
 
-#include <cassert>
+#include <array>
 #include <composite/composite.hh>
 #include <cstdint>
 #include <cstring>
 #include <istream>
+#include <streambuf>
 #include <sstream>
 
 namespace kjson {
@@ -34,36 +37,40 @@ std::string builder(args_t&&... args) {
     return stream.str();
 }
 
-bool is_hex(char c) {
-    return (c >= '0' && c <= '9') ||
-           (c >= 'a' && c <= 'f') ||
-           (c >= 'A' && c <= 'F');
+constexpr array<int8_t, 256> make_hex_table() {
+    array<int8_t, 256> table{};
+    for(size_t i = 0; i < table.size(); ++i) {
+        table[i] = -1;
+    }
+    for(int i = 0; i < 10; ++i) {
+        table['0' + i] = i;
+    }
+    for(int i = 0; i < 6; ++i) {
+        table['a' + i] = 10 + i;
+        table['A' + i] = 10 + i;
+    }
+    return table;
 }
 
-uint8_t single_decode(char h) {
-    if(h >= '0' && h <= '9')
-        return h - '0';
-    else if(h >= 'a' && h <= 'f')
-        return h - 'a' + 10;
-    else if(h >= 'A' && h <= 'F')
-        return h - 'A' + 10;
+constexpr auto hex_table = make_hex_table();
 
-    assert(false);
-    return 0;
+// json whitespace only, isspace() would depend on the locale
+bool is_ws(int c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
 }
 
-int non_ws(istream& str) {
-    char c = 0;
-    while(str.get(c)) {
-        if(!isspace(c))
+int non_ws(streambuf& input) {
+    int c;
+    while((c = input.sbumpc()) != eof) {
+        if(!is_ws(c))
             return c;
     }
     return eof;
 }
 
-token_error<none> extract_literal(istream& input, char head, string const& tail) {
+token_error<none> extract_literal(streambuf& input, char head, string_view tail) {
     for(char e : tail) {
-        int c = input.get();
+        int c = input.sbumpc();
         if(c != e)
             return results::make_err<none>(builder("unexpected char ", (char)c, ", expected ", e, " as part of \"", head, tail, '"'));
     }
@@ -71,31 +78,35 @@ token_error<none> extract_literal(istream& input, char head, string const& tail)
     return results::make_ok<none>();
 }
 
-token_error<token> extract_number(istream& input, char head) {
+token_error<std::monostate> extract_number(streambuf& input, char head, token& t, size_t max_length) {
     bool is_float    = false;
     bool had_point   = false;
     bool had_exp     = false;
     bool is_negative = head == '-';
 
-    string value;
-    value += head;
+    pmr::string& value = t.value;
+    value.assign(1, head);
 
     int c;
-    while((c = input.peek()) != eof) {
+    while((c = input.sgetc()) != eof) {
+        if(value.size() > max_length)
+            return results::make_err<std::monostate>("number exceeds the maximum length");
+
         if(c >= '0' && c <= '9') {
-            input.get();
+            input.sbumpc();
             value += c;
         } else if(!had_point && c == '.') {
-            input.get();
+            input.sbumpc();
             value += c;
             is_float  = true;
             had_point = true;
         } else if(!had_exp && (c == 'e' || c == 'E')) {
-            input.get();
+            input.sbumpc();
             value += c;
 
-            if(input.peek() == '+' || input.peek() == '-') {
-                c = input.get();
+            c = input.sgetc();
+            if(c == '+' || c == '-') {
+                input.sbumpc();
                 value += c;
             }
             is_float = true;
@@ -104,52 +115,86 @@ token_error<token> extract_number(istream& input, char head) {
             break;
     }
 
-    return results::make_ok<token>(token{is_float ? token::type_t::e_float : (is_negative ? token::type_t::e_int : token::type_t::e_uint), move(value)});
-}
-
-token_error<string> extract_utf8(istream& input) {
-    char32_t wc = 0;
-    for(size_t i = 0; i < 4; ++i) {
-        int c = input.get();
-        if(c == eof)
-            break;
+    if(value.size() > max_length)
+        return results::make_err<std::monostate>("number exceeds the maximum length");
 
-        if(!is_hex(c))
-            return results::make_err<string>("expected hex digit");
+    t.tok = is_float ? token::type_t::e_float : (is_negative ? token::type_t::e_int : token::type_t::e_uint);
+    return results::make_ok<std::monostate>();
+}
 
-        wc <<= 4;
-        wc |= single_decode((char)c);
+// returns the code unit of four hex digits, or -1
+int32_t extract_hex4(streambuf& input) {
+    char digits[4];
+    if(input.sgetn(digits, 4) != 4)
+        return -1;
+
+    int32_t v = 0;
+    for(char d : digits) {
+        int8_t h = hex_table[static_cast<unsigned char>(d)];
+        if(h < 0)
+            return -1;
+        v = (v << 4) | h;
     }
+    return v;
+}
 
-    string value;
+void append_utf8(pmr::string& value, char32_t cp) {
+    if(cp < 0x80) {
+        value += static_cast<char>(cp);
+    } else if(cp < 0x800) {
+        char bytes[] = {static_cast<char>(0xc0 | (cp >> 6)),
+                        static_cast<char>(0x80 | (cp & 0x3f))};
+        value.append(bytes, 2);
+    } else if(cp < 0x10000) {
+        char bytes[] = {static_cast<char>(0xe0 | (cp >> 12)),
+                        static_cast<char>(0x80 | ((cp >> 6) & 0x3f)),
+                        static_cast<char>(0x80 | (cp & 0x3f))};
+        value.append(bytes, 3);
+    } else {
+        char bytes[] = {static_cast<char>(0xf0 | (cp >> 18)),
+                        static_cast<char>(0x80 | ((cp >> 12) & 0x3f)),
+                        static_cast<char>(0x80 | ((cp >> 6) & 0x3f)),
+                        static_cast<char>(0x80 | (cp & 0x3f))};
+        value.append(bytes, 4);
+    }
+}
 
-    char byte;
+token_error<none> extract_utf8(streambuf& input, pmr::string& value) {
+    int32_t unit = extract_hex4(input);
+    if(unit < 0)
+        return results::make_err<none>("expected hex digit");
 
-    byte = wc >> 24;
-    if(byte)
-        value += byte;
+    char32_t cp = unit;
+    if(unit >= 0xdc00 && unit <= 0xdfff)
+        return results::make_err<none>("unpaired low surrogate");
 
-    byte = wc >> 16;
-    if(byte)
-        value += byte;
+    if(unit >= 0xd800 && unit <= 0xdbff) {
+        if(input.sbumpc() != '\\' || input.sbumpc() != 'u')
+            return results::make_err<none>("unpaired high surrogate");
 
-    byte = wc >> 8;
-    if(byte)
-        value += byte;
+        int32_t low = extract_hex4(input);
+        if(low < 0xdc00 || low > 0xdfff)
+            return results::make_err<none>("invalid low surrogate");
 
-    byte = wc & 0xff;
-    value += byte;
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+    }
 
-    return results::make_ok<string>(move(value));
+    append_utf8(value, cp);
+    return results::make_ok<none>();
 }
 
-token_error<token> extract_string(istream& input) {
-    string value;
+token_error<none> extract_string(streambuf& input, pmr::string& value, size_t max_length) {
+    value.clear();
+    bool escaped = false;
 
     int c;
-    while((c = input.get()) != eof && c != '"') {
+    while((c = input.sbumpc()) != eof && c != '"') {
+        if(value.size() >= max_length)
+            return results::make_err<none>("string exceeds the maximum length");
+
         if(c == '\\') {
-            c = input.get();
+            escaped = true;
+            c = input.sbumpc();
             switch(c) {
             case '/':
             case '\\':
@@ -174,11 +219,9 @@ token_error<token> extract_string(istream& input) {
                 break;
 
             case 'u': {
-                auto utf8 = extract_utf8(input);
+                auto utf8 = extract_utf8(input, value);
                 if(utf8.is_err())
-                    return utf8.map([](auto&&) { return token{token::type_t::e_eof}; });
-                else
-                    value += utf8.unwrap();
+                    return utf8;
             } break;
 
             default:
@@ -189,35 +232,55 @@ token_error<token> extract_string(istream& input) {
             value += c;
     }
 
-    return results::make_ok<token>(token{token::type_t::e_string, move(value)});
+    // a \u escape can add up to four bytes past the check in the loop
+    if(value.size() > max_length)
+        return results::make_err<none>("string exceeds the maximum length");
+
+    record([&value, escaped](stats& s) {
+        s.string_bytes += value.size();
+        s.escaped_strings += escaped;
+    });
+    return results::make_ok<none>();
 }
-} // namespace
 
-token_error<token> next_token(istream& input) {
-    auto ok = [](token&& t) { return results::make_ok<token>(forward<token>(t)); };
+token_error<std::monostate> done(token_error<none>&& r) {
+    return r.map([](auto&&) { return std::monostate{}; });
+}
+
+token_error<std::monostate> read_token(streambuf& input, token& t, bool defer_strings, size_t max_length) {
+    auto ok = [&t](token::type_t tok) {
+        t.tok = tok;
+        t.value.clear();
+        return results::make_ok<std::monostate>();
+    };
+    auto literal = [&t](token::type_t tok, const char* value) {
+        t.tok = tok;
+        t.value.assign(value);
+        return std::monostate{};
+    };
 
     int c = non_ws(input);
     if(c != eof) {
         switch(c) {
         case '{':
-            return ok({token::type_t::e_start_mapping});
+            return ok(token::type_t::e_start_mapping);
         case '}':
-            return ok({token::type_t::e_end_mapping});
+            return ok(token::type_t::e_end_mapping);
         case '[':
-            return ok({token::type_t::e_start_sequence});
+            return ok(token::type_t::e_start_sequence);
         case ']':
-            return ok({token::type_t::e_end_sequence});
+            return ok(token::type_t::e_end_sequence);
         case ',':
-            return ok({token::type_t::e_separator});
+            return ok(token::type_t::e_separator);
         case ':':
-            return ok({token::type_t::e_mapper});
+            return ok(token::type_t::e_mapper);
 
         case 't':
-            return extract_literal(input, 't', "rue").map([](auto&&) { return token{token::type_t::e_true, "true"}; });
+            return extract_literal(input, 't', "rue").map([&](auto&&) { return literal(token::type_t::e_true, "true"); });
         case 'f':
-            return extract_literal(input, 'f', "alse").map([](auto&&) { return token{token::type_t::e_false, "false"}; });
+            return extract_literal(input, 'f', "alse").map([&](auto&&) { return literal(token::type_t::e_false, "false"); });
         case 'n':
-            return extract_literal(input, 'n', "ull").map([](auto&&) { return token{token::type_t::e_null, "null"}; });
+            return extract_literal(input, 'n', "ull").map([&](auto&&) { return literal(token::type_t::e_null, "null"); });
 
         case '0':
         case '1':
@@ -231,16 +294,69 @@ token_error<token> next_token(istream& input) {
         case '9':
         case '-':
         case '+':
-            return extract_number(input, c);
+            return extract_number(input, c, t, max_length);
 
         case '"':
-            return extract_string(input);
+            if(defer_strings)
+                return ok(token::type_t::e_string);
+            t.tok = token::type_t::e_string;
+            return done(extract_string(input, t.value, max_length));
 
         default:
-            return results::make_err<token>(builder("unexpected token ", (char)c));
+            return results::make_err<std::monostate>(builder("unexpected token ", (char)c));
         }
     }
-    return results::make_ok<token>(token{token::type_t::e_eof});
+    return ok(token::type_t::e_eof);
+}
+} // namespace
+
+static_assert(tuple_size<decltype(stats::tokens)>::value == static_cast<size_t>(token::type_t::e_eof) + 1, "a counter for every token type");
+
+token_error<std::monostate> next_token(streambuf& input, token& t, bool defer_strings, size_t max_length) {
+    auto r = read_token(input, t, defer_strings, max_length);
+    record([&t, &r](stats& s) { s.tokens[static_cast<size_t>(t.tok)] += r.is_ok(); });
+    return r;
+}
+
+token_error<std::monostate> next_string(streambuf& input, token& t, size_t max_length) {
+    t.tok = token::type_t::e_string;
+    return done(extract_string(input, t.value, max_length));
+}
+
+token_error<token> next_token(istream& input, bool defer_strings) {
+    token t;
+    return next_token(*input.rdbuf(), t, defer_strings).map([&t](auto&&) { return std::move(t); });
+}
+
+token_error<token> next_string(istream& input) {
+    token t;
+    return next_string(*input.rdbuf(), t).map([&t](auto&&) { return std::move(t); });
+}
+
+token_error<size_t> next_binary(streambuf& input, pmr::vector<byte>& out, size_t max_length) {
+    out.clear();
+    base64_decoder decoder(out);
+
+    int c;
+    while((c = input.sbumpc()) != eof && c != '"') {
+        // base64 only needs the escaped solidus
+        if(c == '\\' && input.sbumpc() != '/')
+            return results::make_err<size_t>("unexpected escape in base64 string");
+        else if(c == '\\')
+            c = '/';
+
+        if(!decoder.feed(static_cast<char>(c)))
+            return results::make_err<size_t>(builder("invalid base64 character ", (char)c));
+        if(out.size() > max_length)
+            return results::make_err<size_t>("string exceeds the maximum length");
+    }
+
+    if(c == eof)
+        return results::make_err<size_t>("unterminated string");
+    if(!decoder.finish())
+        return results::make_err<size_t>("truncated base64 string");
+
+    return results::make_ok<size_t>(out.size());
 }
 
 } // namespace kjson
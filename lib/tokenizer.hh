@@ -1,9 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <iosfwd>
+#include <limits>
+#include <memory_resource>
 #include <results/result.hh>
 #include <stack>
 #include <string>
+#include <variant>
+#include <vector>
 
 namespace kjson {
 
@@ -29,8 +34,25 @@ struct token {
     };
 
     type_t      tok{type_t::e_eof};
-    std::string value{};
+    std::pmr::string value{};
 };
 
-token_error<token> next_token(std::istream& input);
+// With defer_strings a string token is returned right after its opening quote,
+// the caller then reads it with next_string() or next_binary().
+token_error<token> next_token(std::istream& input, bool defer_strings = false);
+
+token_error<token> next_string(std::istream& input);
+
+constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+// Read into t, reusing the capacity of its value. Strings and numbers longer
+// than max_length bytes are an error. These read the stream buffer directly,
+// without the sentry and locale of an istream.
+token_error<std::monostate> next_token(std::streambuf& input, token& t, bool defer_strings = false,
+                                       std::size_t max_length = unlimited);
+token_error<std::monostate> next_string(std::streambuf& input, token& t, std::size_t max_length = unlimited);
+
+// Decodes a base64 string into out, returning the number of bytes.
+token_error<std::size_t> next_binary(std::streambuf& input, std::pmr::vector<std::byte>& out,
+                                     std::size_t max_length = unlimited);
 } // namespace kjson
@@ -0,0 +1,45 @@
+#include "trace.hh"
+#include "instrument.hh"
+
+namespace kjson {
+
+using namespace std;
+
+thread_local tracer*     t_tracer = nullptr;
+thread_local trace_span* t_span   = nullptr;
+
+trace_scope::trace_scope(tracer& t)
+  : d_previous(t_tracer) {
+    t_tracer = &t;
+}
+
+trace_scope::~trace_scope() {
+    t_tracer = d_previous;
+}
+
+result load(istream& input, tracer& t) {
+    trace_scope scope(t);
+    return load(input);
+}
+
+result load(string_view input, tracer& t) {
+    trace_scope scope(t);
+    return load(input);
+}
+
+maybe_error load(istream& input, visitor& v, tracer& t) {
+    trace_scope scope(t);
+    return load(input, v);
+}
+
+maybe_error load(string_view input, visitor& v, tracer& t) {
+    trace_scope scope(t);
+    return load(input, v);
+}
+
+void dump(const document& data, ostream& out, tracer& t, bool compact) {
+    trace_scope scope(t);
+    dump(data, out, compact);
+}
+
+} // namespace kjson
@@ -0,0 +1,109 @@
+#include "tree.hh"
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+void replay(const tree& t, visitor& v, const string_view* key) {
+    switch(t.kind) {
+    case tree::e_scalar:
+        if(key) {
+            v.scalar(*key, t.value);
+        } else {
+            v.scalar(t.value);
+        }
+        break;
+    case tree::e_sequence:
+        if(key) {
+            v.push_sequence(*key);
+        } else {
+            v.push_sequence();
+        }
+        for(auto&& item : t.items) {
+            replay(item, v, nullptr);
+        }
+        v.pop();
+        break;
+    case tree::e_mapping:
+        if(key) {
+            v.push_mapping(*key);
+        } else {
+            v.push_mapping();
+        }
+        for(auto&& m : t.members) {
+            string_view k = m.first;
+            replay(m.second, v, &k);
+        }
+        v.pop();
+        break;
+    }
+}
+
+} // namespace
+
+const tree* tree::find(string_view key) const {
+    for(auto&& m : members) {
+        if(m.first == key) {
+            return &m.second;
+        }
+    }
+    return nullptr;
+}
+
+void tree_builder::scalar(scalar_t v) {
+    add().value = move(v);
+}
+
+void tree_builder::scalar(string_view key, scalar_t v) {
+    add(key).value = move(v);
+}
+
+void tree_builder::push_sequence() {
+    push(add(), tree::e_sequence);
+}
+
+void tree_builder::push_sequence(string_view key) {
+    push(add(key), tree::e_sequence);
+}
+
+void tree_builder::push_mapping() {
+    push(add(), tree::e_mapping);
+}
+
+void tree_builder::push_mapping(string_view key) {
+    push(add(key), tree::e_mapping);
+}
+
+void tree_builder::pop() {
+    d_stack.pop_back();
+}
+
+tree tree_builder::collect() {
+    d_stack.clear();
+    return exchange(d_root, tree{});
+}
+
+// only the innermost container grows, so the pointers on the stack stay valid
+tree& tree_builder::add() {
+    if(d_stack.empty()) {
+        return d_root;
+    }
+    return d_stack.back()->items.emplace_back();
+}
+
+tree& tree_builder::add(string_view key) {
+    return d_stack.back()->members.emplace_back(string(key), tree{}).second;
+}
+
+void tree_builder::push(tree& t, tree::kind_t kind) {
+    t.kind = kind;
+    d_stack.push_back(&t);
+}
+
+void replay(const tree& t, visitor& v) {
+    replay(t, v, nullptr);
+}
+
+} // namespace kjson
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "visitor.hh"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace kjson {
+
+// A plain value tree built from visitor events, for small values that are
+// inspected more than once, such as schema definitions and query matches.
+struct tree {
+    enum kind_t {
+        e_scalar,
+        e_sequence,
+        e_mapping,
+    };
+
+    kind_t                                    kind{e_scalar};
+    scalar_t                                  value;
+    std::vector<tree>                         items;
+    std::vector<std::pair<std::string, tree>> members;
+
+    const tree* find(std::string_view key) const;
+};
+
+class tree_builder : public visitor {
+  public:
+    void scalar(scalar_t v) override;
+    void scalar(std::string_view key, scalar_t v) override;
+
+    void push_sequence() override;
+    void push_sequence(std::string_view key) override;
+
+    void push_mapping() override;
+    void push_mapping(std::string_view key) override;
+
+    void pop() override;
+
+    tree collect();
+
+  private:
+    tree& add();
+    tree& add(std::string_view key);
+    void  push(tree& t, tree::kind_t kind);
+
+    tree               d_root;
+    std::vector<tree*> d_stack;
+};
+
+void replay(const tree& t, visitor& v);
+
+} // namespace kjson
@@ -0,0 +1,355 @@
+#include "json.hh"
+#include <cstdint>
+#include <istream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+class invalid {
+  public:
+    invalid(const char* p, const char* what)
+      : d_at(p)
+      , d_what(what) {
+    }
+
+    const char* d_at;
+    const char* d_what;
+};
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+int hex_value(char c) {
+    if(is_digit(c)) {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+class validator {
+  public:
+    explicit validator(string_view input)
+      : d_p(input.data())
+      , d_end(input.data() + input.size()) {
+    }
+
+    void run() {
+        enum { e_value, e_next } state = e_value;
+
+        for(;;) {
+            skip_whitespace();
+            if(state == e_value) {
+                switch(peek()) {
+                case '{':
+                    ++d_p;
+                    d_stack.push_back('}');
+                    skip_whitespace();
+                    if(peek() == '}') {
+                        ++d_p;
+                        d_stack.pop_back();
+                        state = e_next;
+                    } else {
+                        key();
+                    }
+                    continue;
+                case '[':
+                    ++d_p;
+                    d_stack.push_back(']');
+                    skip_whitespace();
+                    if(peek() == ']') {
+                        ++d_p;
+                        d_stack.pop_back();
+                        state = e_next;
+                    }
+                    continue;
+                case '"':
+                    string();
+                    break;
+                case 't':
+                    literal("true");
+                    break;
+                case 'f':
+                    literal("false");
+                    break;
+                case 'n':
+                    literal("null");
+                    break;
+                default:
+                    number();
+                    break;
+                }
+                state = e_next;
+                continue;
+            }
+
+            if(d_stack.empty()) {
+                if(d_p != d_end) {
+                    throw invalid(d_p, "trailing characters");
+                }
+                return;
+            }
+
+            char c = peek();
+            if(c == d_stack.back()) {
+                ++d_p;
+                d_stack.pop_back();
+            } else if(c == ',') {
+                ++d_p;
+                state = e_value;
+                if(d_stack.back() == '}') {
+                    skip_whitespace();
+                    key();
+                }
+            } else {
+                throw invalid(d_p, d_stack.back() == '}' ? "expected ',' or '}'" : "expected ',' or ']'");
+            }
+        }
+    }
+
+  private:
+    char peek() const {
+        if(d_p == d_end) {
+            throw invalid(d_p, "unexpected end of input");
+        }
+        return *d_p;
+    }
+
+    void expect(char c, const char* what) {
+        if(peek() != c) {
+            throw invalid(d_p, what);
+        }
+        ++d_p;
+    }
+
+    void skip_whitespace() {
+        while(d_p != d_end && (*d_p == ' ' || *d_p == '\n' || *d_p == '\r' || *d_p == '\t')) {
+            ++d_p;
+        }
+    }
+
+    void key() {
+        if(peek() != '"') {
+            throw invalid(d_p, "expected a key");
+        }
+        string();
+        skip_whitespace();
+        expect(':', "expected ':'");
+    }
+
+    void literal(string_view word) {
+        if(static_cast<size_t>(d_end - d_p) < word.size() || string_view(d_p, word.size()) != word) {
+            throw invalid(d_p, "invalid literal");
+        }
+        d_p += word.size();
+    }
+
+    void digits() {
+        if(d_p == d_end || !is_digit(*d_p)) {
+            throw invalid(d_p, "expected a digit");
+        }
+        while(d_p != d_end && is_digit(*d_p)) {
+            ++d_p;
+        }
+    }
+
+    void number() {
+        if(*d_p == '-') {
+            ++d_p;
+        }
+        if(d_p != d_end && *d_p == '0') {
+            ++d_p;
+        } else if(d_p != d_end && is_digit(*d_p)) {
+            digits();
+        } else {
+            throw invalid(d_p, "expected a value");
+        }
+
+        if(d_p != d_end && *d_p == '.') {
+            ++d_p;
+            digits();
+        }
+        if(d_p != d_end && (*d_p == 'e' || *d_p == 'E')) {
+            ++d_p;
+            if(d_p != d_end && (*d_p == '+' || *d_p == '-')) {
+                ++d_p;
+            }
+            digits();
+        }
+    }
+
+    void string() {
+        ++d_p;
+        for(;;) {
+            skip_plain();
+            auto c = static_cast<unsigned char>(peek());
+            if(c == '"') {
+                ++d_p;
+                return;
+            } else if(c == '\\') {
+                escape();
+            } else if(c < 0x20) {
+                throw invalid(d_p, "control character in string");
+            } else {
+                utf8();
+            }
+        }
+    }
+
+    // skips printable ascii that needs no further attention
+    void skip_plain() {
+#ifdef __SSE2__
+        const __m128i quote     = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i space     = _mm_set1_epi8(' ');
+
+        while(d_end - d_p >= 16) {
+            __m128i chunk   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d_p));
+            __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+            // signed comparison: catches both control characters and non-ascii
+            special  = _mm_or_si128(special, _mm_cmplt_epi8(chunk, space));
+            int mask = _mm_movemask_epi8(special);
+            if(mask != 0) {
+                d_p += __builtin_ctz(static_cast<unsigned>(mask));
+                return;
+            }
+            d_p += 16;
+        }
+#endif
+        while(d_p != d_end) {
+            auto c = static_cast<unsigned char>(*d_p);
+            if(c == '"' || c == '\\' || c < 0x20 || c >= 0x80) {
+                return;
+            }
+            ++d_p;
+        }
+    }
+
+    void escape() {
+        ++d_p;
+        switch(peek()) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            ++d_p;
+            return;
+        case 'u':
+            unicode();
+            return;
+        default:
+            throw invalid(d_p, "invalid escape");
+        }
+    }
+
+    // surrogates must come in pairs, as the tokenizer requires
+    void unicode() {
+        const char* start = d_p - 1;
+        auto        unit  = hex4();
+        if(unit >= 0xdc00 && unit <= 0xdfff) {
+            throw invalid(start, "unpaired low surrogate");
+        }
+        if(unit < 0xd800 || unit > 0xdbff) {
+            return;
+        }
+
+        const char* low_start = d_p;
+        if(d_end - d_p < 2 || d_p[0] != '\\' || d_p[1] != 'u') {
+            throw invalid(d_p, "unpaired high surrogate");
+        }
+        ++d_p;
+        auto low = hex4();
+        if(low < 0xdc00 || low > 0xdfff) {
+            throw invalid(low_start, "invalid low surrogate");
+        }
+    }
+
+    // d_p is on the 'u' of an escape
+    int hex4() {
+        ++d_p;
+        int unit = 0;
+        for(int i = 0; i < 4; ++i) {
+            int digit = hex_value(peek());
+            if(digit < 0) {
+                throw invalid(d_p, "invalid unicode escape");
+            }
+            unit = unit << 4 | digit;
+            ++d_p;
+        }
+        return unit;
+    }
+
+    void utf8() {
+        auto byte = [this](ptrdiff_t i) {
+            return d_end - d_p > i ? static_cast<unsigned char>(d_p[i]) : 0;
+        };
+        auto cont = [](unsigned char c, unsigned char lo = 0x80, unsigned char hi = 0xbf) {
+            return c >= lo && c <= hi;
+        };
+
+        auto c = byte(0);
+        bool ok;
+        int  n;
+        if(c >= 0xc2 && c <= 0xdf) {
+            n  = 2;
+            ok = cont(byte(1));
+        } else if(c >= 0xe0 && c <= 0xef) {
+            n  = 3;
+            ok = cont(byte(1), c == 0xe0 ? 0xa0 : 0x80, c == 0xed ? 0x9f : 0xbf) && cont(byte(2));
+        } else if(c >= 0xf0 && c <= 0xf4) {
+            n  = 4;
+            ok = cont(byte(1), c == 0xf0 ? 0x90 : 0x80, c == 0xf4 ? 0x8f : 0xbf) && cont(byte(2)) && cont(byte(3));
+        } else {
+            n  = 1;
+            ok = false;
+        }
+
+        if(!ok) {
+            throw invalid(d_p, "invalid utf-8");
+        }
+        d_p += n;
+    }
+
+    const char*  d_p;
+    const char*  d_end;
+    vector<char> d_stack;
+};
+
+} // namespace
+
+validation validate(string_view input) {
+    validator v(input);
+    try {
+        v.run();
+        return {true, input.size(), {}};
+    } catch(const invalid& e) {
+        return {false, static_cast<size_t>(e.d_at - input.data()), e.d_what};
+    }
+}
+
+validation validate(istream& input) {
+    std::string buffer(istreambuf_iterator<char>(input), {});
+    return validate(buffer);
+}
+
+} // namespace kjson
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <streambuf>
+#include <string_view>
+
+namespace kjson {
+
+// Read-only stream buffer over memory that is not owned, to parse a
+// string_view without copying it into a string stream.
+class view_buffer : public std::streambuf {
+  public:
+    explicit view_buffer(std::string_view data) {
+        reset(data);
+    }
+
+    void reset(std::string_view data) {
+        auto begin = const_cast<char*>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+
+  protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+        off_type pos  = base + off;
+        if(!(which & std::ios_base::in) || pos < 0 || pos > egptr() - eback()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+} // namespace kjson
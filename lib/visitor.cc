@@ -1 +1,84 @@
 #include "visitor.hh"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace kjson {
+
+using namespace std;
+
+namespace {
+
+// the strto* functions need a terminated string
+template <typename F>
+auto convert(string_view text, F&& f) {
+    char buf[64];
+    if(text.size() < sizeof(buf)) {
+        memcpy(buf, text.data(), text.size());
+        buf[text.size()] = '\0';
+        return f(buf);
+    }
+    return f(string(text).c_str());
+}
+
+bool digits(string_view text, size_t& i) {
+    size_t start = i;
+    while(i < text.size() && text[i] >= '0' && text[i] <= '9') {
+        ++i;
+    }
+    return i > start;
+}
+
+} // namespace
+
+bool raw_number::valid() const {
+    size_t i = 0;
+    if(i < text.size() && text[i] == '-') {
+        ++i;
+    }
+
+    size_t start = i;
+    if(!digits(text, i) || (text[start] == '0' && i - start > 1)) {
+        return false;
+    }
+    if(i < text.size() && text[i] == '.' && !digits(text, ++i)) {
+        return false;
+    }
+    if(i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        if(i < text.size() && (text[i] == '+' || text[i] == '-')) {
+            ++i;
+        }
+        if(!digits(text, i)) {
+            return false;
+        }
+    }
+    return i == text.size();
+}
+
+int64_t raw_number::as_int() const {
+    static_assert(sizeof(long long) >= sizeof(int64_t), "long long not long enough");
+
+    return convert(text, [](const char* s) { return static_cast<int64_t>(strtoll(s, nullptr, 10)); });
+}
+
+uint64_t raw_number::as_uint() const {
+    static_assert(sizeof(unsigned long long) >= sizeof(uint64_t), "unsigned long long not long enough");
+
+    return convert(text, [](const char* s) { return static_cast<uint64_t>(strtoull(s, nullptr, 10)); });
+}
+
+double raw_number::as_float() const {
+    return convert(text, [](const char* s) { return strtod(s, nullptr); });
+}
+
+scalar_t raw_number::value() const {
+    if(text.find_first_of(".eE") != string_view::npos) {
+        return as_float();
+    } else if(!text.empty() && text[0] == '-') {
+        return as_int();
+    }
+    return as_uint();
+}
+
+} // namespace kjson
@@ -0,0 +1,77 @@
+#include "base64.hh"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+string encode(string_view data) {
+    string out(base64_size(data.size()), '\0');
+    base64_encode(reinterpret_cast<const byte*>(data.data()), data.size(), out.data());
+    return out;
+}
+
+bool decode(string_view encoded, string& out) {
+    pmr::vector<byte> bytes;
+    base64_decoder decoder(bytes);
+    for(char c : encoded) {
+        if(!decoder.feed(c)) {
+            return false;
+        }
+    }
+    if(!decoder.finish()) {
+        return false;
+    }
+    out.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    return true;
+}
+
+TEST(base64, rfc4648) {
+    vector<pair<string, string>> vectors = {
+        {"", ""},
+        {"f", "Zg=="},
+        {"fo", "Zm8="},
+        {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="},
+        {"fooba", "Zm9vYmE="},
+        {"foobar", "Zm9vYmFy"},
+        {"\xfb\xff\xfe", "+//+"},
+    };
+
+    for(auto&& [plain, encoded] : vectors) {
+        EXPECT_EQ(encoded, encode(plain));
+
+        string decoded;
+        ASSERT_TRUE(decode(encoded, decoded)) << encoded;
+        EXPECT_EQ(plain, decoded);
+    }
+}
+
+TEST(base64, unpadded) {
+    string decoded;
+    ASSERT_TRUE(decode("Zm9vYg", decoded));
+    EXPECT_EQ("foob", decoded);
+}
+
+TEST(base64, invalid) {
+    string decoded;
+    for(auto input : {"Z", "Zm9vY", "Zm9v!", "Z===", "Zm=v", "Zm9v=", "Zg==Zg==", "Zm 9v"}) {
+        EXPECT_FALSE(decode(input, decoded)) << input;
+    }
+}
+
+TEST(base64, all_bytes) {
+    string all;
+    for(int i = 0; i < 256; ++i) {
+        all += static_cast<char>(i);
+    }
+
+    string decoded;
+    ASSERT_TRUE(decode(encode(all), decoded));
+    EXPECT_EQ(all, decoded);
+}
+
+} // namespace
+} // namespace kjson
@@ -255,6 +255,27 @@ TEST(builder, empty_formatting) {
 })", stream.str());
 }
 
+TEST(builder, binary) {
+    ostringstream stream;
+
+    string data = "any carnal pleas";
+    string large(5000, '\xff');
+
+    builder(stream, true)
+            .push_mapping()
+            .key("b").with_binary(reinterpret_cast<const byte*>(data.data()), data.size())
+            .key("e").with_binary(nullptr, 0)
+            .key("l").with_binary(reinterpret_cast<const byte*>(large.data()), large.size())
+            .flush();
+
+    string encoded;
+    for(size_t i = 0; i < 5000 / 3; ++i) {
+        encoded += "////";
+    }
+    encoded += "//8=";
+    EXPECT_EQ(R"({"b":"YW55IGNhcm5hbCBwbGVhcw==","e":"","l":")" + encoded + R"("})", stream.str());
+}
+
 TEST(builder, check_bad_key) {
     ostringstream stream;
 
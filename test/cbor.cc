@@ -0,0 +1,206 @@
+#include "cbor.hh"
+#include "json_writer.hh"
+#include <composite/make.hh>
+#include <gtest/gtest.h>
+#include <limits>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+using namespace composite;
+
+string unhex(string_view hex) {
+    string result;
+    for(size_t i = 0; i + 1 < hex.size(); i += 2) {
+        result += static_cast<char>(stoi(string(hex.substr(i, 2)), nullptr, 16));
+    }
+    return result;
+}
+
+string encode(scalar_t v) {
+    ostringstream stream;
+    cbor_writer(stream).scalar(move(v));
+    return stream.str();
+}
+
+struct cbor_testcase {
+    string   hex;
+    document expected;
+};
+
+inline ostream& operator<<(ostream& o, cbor_testcase const& tc) {
+    return o << tc.hex;
+}
+
+class cbor_decode_test : public testing::TestWithParam<cbor_testcase> {
+};
+
+TEST_P(cbor_decode_test, decode) {
+    auto actual = load_cbor(unhex(GetParam().hex));
+
+    ASSERT_TRUE(actual.is_ok());
+    EXPECT_EQ(GetParam().expected, actual.unwrap());
+}
+
+// examples from RFC 8949 appendix A
+cbor_testcase cbor_testcases[] = {
+    {"00", make(0u)},
+    {"17", make(23u)},
+    {"1818", make(24u)},
+    {"1903e8", make(1000u)},
+    {"1b000000e8d4a51000", make(1000000000000u)},
+    {"1bffffffffffffffff", make(numeric_limits<uint64_t>::max())},
+    {"20", make(-1)},
+    {"3903e7", make(-1000)},
+    {"3b7fffffffffffffff", make(numeric_limits<int64_t>::min())},
+    {"f93c00", make(1.0)},
+    {"f97bff", make(65504.0)},
+    {"f9c400", make(-4.0)},
+    {"fa47c35000", make(100000.0)},
+    {"fb3ff199999999999a", make(1.1)},
+    {"f4", make(false)},
+    {"f5", make(true)},
+    {"f6", make(::composite::none{})},
+    {"60", make("")},
+    {"6449455446", make("IETF")},
+    {"62c3bc", make("\xc3\xbc")},
+    {"7f657374726561646d696e67ff", make("streaming")},
+    {"c074323031332d30332d32315432303a30343a30305a", make("2013-03-21T20:04:00Z")},
+    {"80", make_seq()},
+    {"83010203", make_seq(1u, 2u, 3u)},
+    {"8301820203820405", make_seq(1u, make_seq(2u, 3u), make_seq(4u, 5u))},
+    {"9f018202039f0405ffff", make_seq(1u, make_seq(2u, 3u), make_seq(4u, 5u))},
+    {"a0", make_map()},
+    {"a26161016162820203", make_map("a", 1u, "b", make_seq(2u, 3u))},
+    {"bf6346756ef563416d7421ff", make_map("Fun", true, "Amt", -2)},
+};
+
+INSTANTIATE_TEST_SUITE_P(cbor_decode_tests,
+                         cbor_decode_test,
+                         testing::ValuesIn(cbor_testcases));
+
+TEST(cbor, encode_scalars) {
+    EXPECT_EQ(unhex("00"), encode(uint64_t{0}));
+    EXPECT_EQ(unhex("17"), encode(uint64_t{23}));
+    EXPECT_EQ(unhex("1818"), encode(uint64_t{24}));
+    EXPECT_EQ(unhex("1903e8"), encode(int64_t{1000}));
+    EXPECT_EQ(unhex("1a000f4240"), encode(uint64_t{1000000}));
+    EXPECT_EQ(unhex("1bffffffffffffffff"), encode(numeric_limits<uint64_t>::max()));
+    EXPECT_EQ(unhex("20"), encode(int64_t{-1}));
+    EXPECT_EQ(unhex("3863"), encode(int64_t{-100}));
+    EXPECT_EQ(unhex("3b7fffffffffffffff"), encode(numeric_limits<int64_t>::min()));
+    EXPECT_EQ(unhex("fb3ff199999999999a"), encode(1.1));
+    EXPECT_EQ(unhex("f4"), encode(false));
+    EXPECT_EQ(unhex("f5"), encode(true));
+    EXPECT_EQ(unhex("f6"), encode(none{}));
+    EXPECT_EQ(unhex("6449455446"), encode(string("IETF")));
+}
+
+TEST(cbor, encode_containers) {
+    ostringstream stream;
+    {
+        cbor_writer w(stream);
+        w.push_mapping();
+        w.scalar("a", uint64_t{1});
+        w.push_sequence("b");
+        w.scalar(uint64_t{2});
+        w.pop();
+        w.pop();
+    }
+
+    EXPECT_EQ(unhex("bf61610161629f02ffff"), stream.str());
+}
+
+TEST(cbor, round_trip) {
+    auto doc = make_map("key", "value", "list", make_seq("string", -1, true, make_map("pi", 3.14, "e", 2.71)), "none", ::composite::none{});
+
+    stringstream stream;
+    dump_cbor(doc, stream);
+
+    EXPECT_EQ(doc, load_cbor(stream).unwrap());
+}
+
+TEST(cbor, to_json) {
+    ostringstream out;
+    json_writer   w(out);
+
+    ASSERT_TRUE(load_cbor(unhex("a26161016162820203"), w).is_ok());
+    EXPECT_EQ(R"({"a":1,"b":[2,3]})", out.str());
+}
+
+TEST(cbor, bytes_to_json) {
+    ostringstream out;
+    json_writer   w(out);
+
+    ASSERT_TRUE(load_cbor(unhex("a1616443666f6f"), w).is_ok());
+    EXPECT_EQ(R"({"d":"Zm9v"})", out.str());
+}
+
+TEST(cbor, encode_bytes) {
+    ostringstream out;
+    {
+        cbor_writer w(out);
+        string      data = "foo";
+        w.binary(reinterpret_cast<const byte*>(data.data()), data.size());
+    }
+    EXPECT_EQ(unhex("43666f6f"), out.str());
+}
+
+TEST(cbor, from_json) {
+    ostringstream out;
+    cbor_writer   w(out);
+
+    ASSERT_TRUE(load(R"({"a": 1, "b": [2, 3]})", w).is_ok());
+    w.flush();
+    EXPECT_EQ(unhex("bf61610161629f0203ffff"), out.str());
+}
+
+TEST(cbor, errors) {
+    EXPECT_TRUE(load_cbor(unhex("")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("1a0000")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("830102")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("a10102")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("0101")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("1c")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("ff")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("7aff000000")).is_err());
+
+    // NaN and infinity can not be dumped as json
+    EXPECT_TRUE(load_cbor(unhex("82f97e00f97c00")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("f9fc00")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("fa7f800000")).is_err());
+    EXPECT_TRUE(load_cbor(unhex("fb7ff8000000000000")).is_err());
+
+    // nesting is limited by the input, not the call stack
+    ostringstream out;
+    json_writer   w(out);
+    EXPECT_TRUE(load_cbor(string(2000000, '\xc0') + '\xf6', w).is_ok());
+    EXPECT_TRUE(load_cbor(string(2000000, '\x81'), w).is_err());
+
+    limits l;
+    l.max_depth = 100;
+    EXPECT_TRUE(load_cbor(string(101, '\x81') + '\xf6', w, l).is_err());
+    EXPECT_TRUE(load_cbor(string(100, '\x81') + '\xf6', l).is_ok());
+    EXPECT_TRUE(load_cbor(string(101, '\x9f') + '\xf6' + string(101, '\xff'), w, l).is_err());
+
+    l             = limits{};
+    l.max_members = 2;
+    EXPECT_TRUE(load_cbor(unhex("83010203"), l).is_err());
+    EXPECT_TRUE(load_cbor(unhex("9f010203ff"), l).is_err());
+    EXPECT_TRUE(load_cbor(unhex("820102"), l).is_ok());
+
+    l            = limits{};
+    l.max_string = 2;
+    EXPECT_TRUE(load_cbor(unhex("63616263"), l).is_err());
+    EXPECT_TRUE(load_cbor(unhex("7f6161626263ff"), l).is_err());
+
+    l          = limits{};
+    l.max_size = 3;
+    EXPECT_TRUE(load_cbor(unhex("83010203"), l).is_err());
+    EXPECT_TRUE(load_cbor(unhex("820102"), l).is_ok());
+}
+
+} // namespace
+} // namespace kjson
@@ -0,0 +1,167 @@
+#include "describe.hh"
+#include "json.hh"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+struct point {
+    int    x;
+    double y;
+};
+
+KJSON_DESCRIBE(point, x, y)
+
+struct shape {
+    string                       name;
+    bool                         closed{false};
+    uint64_t                     id{0};
+    vector<point>                points;
+    optional<string>             label;
+    optional<point>              origin;
+    map<string, int>             tags;
+    unordered_map<string, point> anchors;
+};
+
+KJSON_DESCRIBE(shape, name, closed, id, points, label, origin, tags, anchors)
+
+template <typename T>
+string to_json(const T& v, bool compact) {
+    ostringstream stream;
+    dump(v, stream, compact);
+    return stream.str();
+}
+
+TEST(describe, fields) {
+    constexpr auto fields = fields_of<point>();
+
+    static_assert(std::tuple_size_v<decltype(fields)> == 2);
+    static_assert(std::get<0>(fields).name == "x");
+    static_assert(std::get<0>(fields).escaped_name == "\"x\"");
+    static_assert(std::get<1>(fields).name == "y");
+
+    static_assert(is_described_v<point>);
+    static_assert(!is_described_v<int>);
+    static_assert(!is_described_v<document>);
+}
+
+TEST(describe, compact) {
+    point p{1, 2.5};
+
+    EXPECT_EQ(R"({"x":1,"y":2.5})", to_json(p, true));
+}
+
+TEST(describe, pretty) {
+    point p{-1, 0.5};
+
+    EXPECT_EQ("{\n  \"x\": -1,\n  \"y\": 0.5\n}", to_json(p, false));
+}
+
+TEST(describe, nested) {
+    shape s;
+    s.name   = R"(tri"angle)";
+    s.closed = true;
+    s.id     = 0xffffffffffffffff;
+    s.points = {{0, 0}, {1, 0}};
+    s.origin = point{3, 4};
+    s.tags   = {{"a", 1}, {"b", 2}};
+    s.anchors.insert({"c", point{5, 6}});
+
+    EXPECT_EQ(R"({"name":"tri\"angle","closed":true,"id":18446744073709551615,)"
+              R"("points":[{"x":0,"y":0},{"x":1,"y":0}],"label":null,"origin":{"x":3,"y":4},)"
+              R"("tags":{"a":1,"b":2},"anchors":{"c":{"x":5,"y":6}}})",
+              to_json(s, true));
+}
+
+TEST(describe, matches_document_dump) {
+    shape s;
+    s.name   = "square";
+    s.points = {{0, 0}, {1, 1}};
+    s.label  = "sq";
+
+    for(bool compact : {true, false}) {
+        auto          doc = load(to_json(s, compact)).unwrap();
+        ostringstream stream;
+        dump(doc, stream, compact);
+
+        auto reloaded = load(stream.str()).unwrap();
+        EXPECT_EQ(doc, reloaded);
+    }
+}
+
+TEST(describe, perfect_hash) {
+    using index = detail::field_index<shape>;
+
+    for(auto&& name : {"name", "closed", "id", "points", "label", "origin", "tags", "anchors"}) {
+        auto i = index::hash.find(name);
+        ASSERT_LT(i, index::size);
+        EXPECT_EQ(name, index::hash.names[i]);
+    }
+
+    EXPECT_EQ(index::size, index::hash.find("unknown"));
+    EXPECT_EQ(index::size, index::hash.find(""));
+    EXPECT_EQ(index::size, index::hash.find("names"));
+}
+
+TEST(describe, load_into) {
+    shape s;
+    s.label = "stale";
+
+    auto r = load_into(R"({
+        "name": "tri\"angle",
+        "closed": true,
+        "id": 18446744073709551615,
+        "points": [{"x": 0, "y": 0}, {"x": -1, "y": 2.5}],
+        "label": null,
+        "origin": {"x": 3, "y": 4, "z": 5},
+        "unknown": {"nested": [1, 2, {"a": []}]},
+        "tags": {"a": 1, "b": 2},
+        "anchors": {"c": {"x": 5, "y": 6}}
+    })",
+                       s);
+
+    ASSERT_TRUE(r.is_ok());
+    EXPECT_EQ(R"(tri"angle)", s.name);
+    EXPECT_TRUE(s.closed);
+    EXPECT_EQ(0xffffffffffffffff, s.id);
+    ASSERT_EQ(2u, s.points.size());
+    EXPECT_EQ(-1, s.points[1].x);
+    EXPECT_EQ(2.5, s.points[1].y);
+    EXPECT_FALSE(s.label);
+    ASSERT_TRUE(s.origin);
+    EXPECT_EQ(3, s.origin->x);
+    EXPECT_EQ((map<string, int>{{"a", 1}, {"b", 2}}), s.tags);
+    EXPECT_EQ(6.0, s.anchors.at("c").y);
+}
+
+TEST(describe, round_trip) {
+    shape orig;
+    orig.name    = "square";
+    orig.id      = 42;
+    orig.points  = {{0, 0}, {1, 1}};
+    orig.label   = "sq";
+    orig.tags    = {{"t", -3}};
+    orig.anchors = {{"a", {7, 8}}};
+
+    shape actual;
+    ASSERT_TRUE(load_into(to_json(orig, false), actual).is_ok());
+
+    EXPECT_EQ(to_json(orig, true), to_json(actual, true));
+}
+
+TEST(describe, load_into_type_errors) {
+    point p;
+
+    EXPECT_TRUE(load_into(R"({"x": "one"})", p).is_err());
+    EXPECT_TRUE(load_into(R"({"x": 1.5})", p).is_err());
+    EXPECT_TRUE(load_into(R"({"x": 4294967296})", p).is_err());
+    EXPECT_TRUE(load_into(R"({"x": [1]})", p).is_err());
+    EXPECT_TRUE(load_into(R"([1, 2])", p).is_err());
+    EXPECT_TRUE(load_into(R"(1)", p).is_err());
+}
+
+} // namespace
+} // namespace kjson
@@ -0,0 +1,60 @@
+#include "diff.hh"
+#include <gtest/gtest.h>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+document doc(string_view json) {
+    return load(json).unwrap();
+}
+
+TEST(hash, structural) {
+    EXPECT_EQ(hash(doc(R"({"a": 1, "b": [1, 2]})")), hash(doc(R"({"b": [1, 2], "a": 1})")));
+    EXPECT_EQ(hash(doc("[1, -1]")), hash(doc("[1.0, -1.0]")));
+    EXPECT_NE(hash(doc("[1, 2]")), hash(doc("[2, 1]")));
+    EXPECT_NE(hash(doc(R"({"a": 1})")), hash(doc(R"({"b": 1})")));
+    EXPECT_NE(hash(doc(R"("1")")), hash(doc("1")));
+    EXPECT_NE(hash(doc("[]")), hash(doc("{}")));
+    EXPECT_NE(hash(doc("[[]]")), hash(doc("[]")));
+    EXPECT_NE(hash(doc("null")), hash(doc("false")));
+    EXPECT_NE(hash(doc("1.5")), hash(doc("1")));
+}
+
+TEST(hash, cached) {
+    merkle a(doc(R"({"a": [1, 2, {"b": null}]})"));
+    merkle b(doc(R"({"a": [1, 2, {"b": null}]})"));
+    EXPECT_EQ(a.hash(), b.hash());
+}
+
+struct diff_testcase {
+    string from;
+    string to;
+    string patch;
+};
+
+inline ostream& operator<<(ostream& o, diff_testcase const& tc) {
+    return o << tc.from << " -> " << tc.to;
+}
+
+class json_patch_test : public testing::TestWithParam<diff_testcase> {
+};
+
+TEST_P(json_patch_test, diff) {
+    EXPECT_EQ(doc(GetParam().patch), diff(doc(GetParam().from), doc(GetParam().to)));
+}
+
+INSTANTIATE_TEST_SUITE_P(diff, json_patch_test, testing::Values(diff_testcase{R"({"a": 1})", R"({"a": 1})", "[]"}, diff_testcase{"1", "2", R"([{"op": "replace", "path": "", "value": 2}])"}, diff_testcase{R"({"a": 1, "b": 2})", R"({"b": 3, "c": [4]})", R"([{"op": "remove", "path": "/a"}, {"op": "replace", "path": "/b", "value": 3}, {"op": "add", "path": "/c", "value": [4]}])"}, diff_testcase{R"({"x": {"y": {"z": 1, "w": 2}}, "big": [1, 2, 3]})", R"({"x": {"y": {"z": 5, "w": 2}}, "big": [1, 2, 3]})", R"([{"op": "replace", "path": "/x/y/z", "value": 5}])"}, diff_testcase{"[1, 2, 3, 4]", "[1, 4]", R"([{"op": "remove", "path": "/2"}, {"op": "remove", "path": "/1"}])"}, diff_testcase{"[1, 4]", "[1, 2, 3, 4]", R"([{"op": "add", "path": "/1", "value": 2}, {"op": "add", "path": "/2", "value": 3}])"}, diff_testcase{"[1, 2, 3]", "[1, 5, 3]", R"([{"op": "replace", "path": "/1", "value": 5}])"}, diff_testcase{R"({"a/b": 1, "c~d": 2})", R"({"a/b": 2, "c~d": 3})", R"([{"op": "replace", "path": "/a~1b", "value": 2}, {"op": "replace", "path": "/c~0d", "value": 3}])"}, diff_testcase{R"({"a": []})", R"({"a": {}})", R"([{"op": "replace", "path": "/a", "value": {}}])"}));
+
+class merge_patch_test : public testing::TestWithParam<diff_testcase> {
+};
+
+TEST_P(merge_patch_test, diff) {
+    EXPECT_EQ(doc(GetParam().patch), diff(doc(GetParam().from), doc(GetParam().to), patch_format::e_merge_patch));
+}
+
+INSTANTIATE_TEST_SUITE_P(diff, merge_patch_test, testing::Values(diff_testcase{R"({"a": 1})", R"({"a": 1})", "{}"}, diff_testcase{R"({"a": 1, "b": 2})", R"({"b": 3, "c": 4})", R"({"a": null, "b": 3, "c": 4})"}, diff_testcase{R"({"x": {"y": 1, "z": 2}, "s": [1]})", R"({"x": {"y": 1, "z": 3}, "s": [1]})", R"({"x": {"z": 3}})"}, diff_testcase{"[1, 2]", "[1, 3]", "[1, 3]"}, diff_testcase{R"({"a": [1]})", R"({"a": [2]})", R"({"a": [2]})"}));
+
+} // namespace
+} // namespace kjson
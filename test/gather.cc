@@ -0,0 +1,157 @@
+#include "gather.hh"
+#include "builder.hh"
+#include <composite/make.hh>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+using namespace composite;
+
+string contents(const gather& g) {
+    string result;
+    for(auto&& iov : g.buffers()) {
+        result.append(static_cast<const char*>(iov.iov_base), iov.iov_len);
+    }
+    return result;
+}
+
+string flushed(gather& g) {
+    FILE* f = tmpfile();
+    EXPECT_NE(nullptr, f);
+
+    EXPECT_TRUE(g.flush(fileno(f)).is_ok());
+
+    string result(static_cast<size_t>(ftell(f)), '\0');
+    rewind(f);
+    EXPECT_EQ(result.size(), fread(&result[0], 1, result.size(), f));
+    fclose(f);
+
+    return result;
+}
+
+TEST(gather, appends_are_coalesced) {
+    gather g;
+    g.append("foo");
+    g.append("bar");
+
+    EXPECT_EQ(1u, g.buffers().size());
+    EXPECT_EQ(6u, g.size());
+    EXPECT_EQ("foobar", contents(g));
+}
+
+TEST(gather, large_references_are_not_copied) {
+    string large(32, 'x');
+    string small(4, 'y');
+
+    gather g(16);
+    g.append("[");
+    g.reference(large);
+    g.reference(small);
+    g.append("]");
+
+    ASSERT_EQ(3u, g.buffers().size());
+    EXPECT_EQ(large.data(), g.buffers()[1].iov_base);
+    EXPECT_EQ("[" + large + small + "]", contents(g));
+}
+
+TEST(gather, flush_writes_and_clears) {
+    string large(100000, 'z');
+
+    gather g(1);
+    for(int i = 0; i < 2000; ++i) {
+        g.append(",");
+        g.reference(string_view(large).substr(0, 10));
+    }
+
+    auto expected = contents(g);
+    EXPECT_EQ(expected, flushed(g));
+    EXPECT_TRUE(g.buffers().empty());
+    EXPECT_EQ(0u, g.size());
+}
+
+TEST(gather, flush_bad_fd) {
+    gather g;
+    g.append("data");
+    EXPECT_TRUE(g.flush(-1).is_err());
+}
+
+TEST(gather, builder_matches_stream) {
+    string blob(1000, 'b');
+    blob += "\"quoted\\";
+    blob += string(1000, 'c');
+
+    for(bool compact : {true, false}) {
+        auto build = [&](builder& b) {
+            b.push_mapping()
+                .key("blob")
+                .with_string(blob)
+                .key("n")
+                .with_int(-1)
+                .key("f")
+                .with_float(3.14)
+                .key("s")
+                .push_sequence()
+                .with_none()
+                .with_bool(true)
+                .with_uint(0xffffffffffffffff)
+                .flush();
+        };
+
+        ostringstream stream;
+        builder       bs(stream, compact);
+        build(bs);
+
+        gather  g(64);
+        builder bg(g, compact);
+        build(bg);
+
+        EXPECT_EQ(stream.str(), contents(g));
+    }
+}
+
+TEST(gather, builder_copies_strings_by_default) {
+    string large(32, 'x');
+    auto   points_into = [](const gather& g, const string& s) {
+        for(auto&& iov : g.buffers()) {
+            if(iov.iov_base == s.data()) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    gather  copied(16);
+    builder bc(copied, true);
+    bc.push_sequence().with_string(large).with_string(string(32, 'y')).flush();
+    EXPECT_FALSE(points_into(copied, large));
+    EXPECT_EQ("[\"" + large + "\",\"" + string(32, 'y') + "\"]", contents(copied));
+
+    gather  referenced(16);
+    builder br(referenced, false, pmr::get_default_resource(), gather_strings::e_reference);
+    br.with_string(large).flush();
+    EXPECT_TRUE(points_into(referenced, large));
+}
+
+TEST(gather, dump_matches_stream) {
+    string blob(4096, 'v');
+    auto   doc = make_map("blob", blob, "list", make_seq(1, -2, 3.5, "x", make_seq(blob)), "m", make_map());
+
+    for(bool compact : {true, false}) {
+        ostringstream stream;
+        dump(doc, stream, compact);
+
+        gather g;
+        dump(doc, g, compact);
+
+        EXPECT_EQ(stream.str(), flushed(g));
+    }
+}
+
+} // namespace
+} // namespace kjson
@@ -3,6 +3,7 @@
 #include <composite/make.hh>
 #include <gtest/gtest.h>
 #include <limits>
+#include <memory_resource>
 #include <rapidcheck/gtest.h>
 
 namespace kjson {
@@ -45,6 +46,41 @@ TEST(toplevel, incomplete) {
     EXPECT_TRUE(actual.is_err());
 }
 
+TEST(toplevel, limits) {
+    auto fits = [](string_view input, limits l) { return load(input, l).is_ok(); };
+
+    limits depth;
+    depth.max_depth = 2;
+    EXPECT_TRUE(fits("[[1]]", depth));
+    EXPECT_FALSE(fits("[[[1]]]", depth));
+    EXPECT_FALSE(fits(string(100000, '[') + string(100000, ']'), depth));
+
+    limits size;
+    size.max_size = 8;
+    EXPECT_TRUE(fits("[1, 2]  ", size));
+    EXPECT_FALSE(fits("[1, 2, 3]", size));
+    EXPECT_FALSE(fits("[1, 2]   ", size));
+
+    limits strings;
+    strings.max_string = 4;
+    EXPECT_TRUE(fits(R"({"abcd": "\u00e9\u00e9"})", strings));
+    EXPECT_FALSE(fits(R"({"abcde": 1})", strings));
+    EXPECT_FALSE(fits(R"(["abcde"])", strings));
+    EXPECT_FALSE(fits(R"(["abc\u00e9"])", strings));
+    EXPECT_FALSE(fits("[12345]", strings));
+
+    limits members;
+    members.max_members = 2;
+    EXPECT_TRUE(fits(R"({"a": [1, 2], "b": {}})", members));
+    EXPECT_FALSE(fits("[1, 2, 3]", members));
+    EXPECT_FALSE(fits(R"({"a": 1, "b": 2, "c": 3})", members));
+
+    limits nodes;
+    nodes.max_nodes = 4;
+    EXPECT_TRUE(fits("[1, [2]]", nodes));
+    EXPECT_FALSE(fits("[1, [2, 3]]", nodes));
+}
+
 TEST(toplevel, uint) {
     ::composite::composite doc((uint64_t)0xffffffffffffffff);
     stringstream           stream;
@@ -53,6 +89,36 @@ TEST(toplevel, uint) {
     EXPECT_EQ("18446744073709551615", stream.str());
 }
 
+class counting_resource : public std::pmr::memory_resource {
+  public:
+    size_t d_allocations{0};
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++d_allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+TEST(toplevel, dump_resource) {
+    auto doc = make_map("list", make_seq(1, make_seq(2, make_map("a", none{}))));
+
+    counting_resource resource;
+    stringstream      stream;
+    dump(doc, stream, &resource);
+
+    EXPECT_EQ(R"({"list":[1,[2,{"a":null}]]})", stream.str());
+    EXPECT_LT(0u, resource.d_allocations);
+}
+
 template <typename T>
 bool check_marshalling(const T& orig, bool compact) {
     auto         doc = make(T(orig));
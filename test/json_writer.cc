@@ -0,0 +1,87 @@
+#include "json_writer.hh"
+#include "json.hh"
+#include <composite/make.hh>
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+using namespace composite;
+
+TEST(json_writer, events) {
+    ostringstream stream;
+    {
+        json_writer w(stream);
+        w.push_mapping();
+        w.scalar("a", none{});
+        w.push_sequence("b");
+        w.scalar(true);
+        w.scalar(int64_t{-1});
+        w.scalar(uint64_t{1});
+        w.scalar(1.5);
+        w.scalar(string(R"(q"uote)"));
+        w.push_mapping();
+        w.pop();
+        w.pop();
+        w.push_mapping("c");
+        w.pop();
+        w.pop();
+    }
+
+    EXPECT_EQ(R"({"a":null,"b":[true,-1,1,1.5,"q\"uote",{}],"c":{}})", stream.str());
+}
+
+TEST(json_writer, pretty_matches_builder) {
+    const string input = R"({"list": [1, -2, {"x": "y"}, []], "m": {}, "s": "str"})";
+
+    ostringstream expected;
+    dump(load(input).unwrap(), expected, false);
+
+    ostringstream actual;
+    {
+        json_writer w(actual, false);
+        ASSERT_TRUE(load(input, w).is_ok());
+    }
+
+    EXPECT_EQ(expected.str(), actual.str());
+}
+
+TEST(json_writer, walk) {
+    auto doc = make_map("key", "value", "list", make_seq("string", -1, true, make_map("pi", 3.5)), "none", ::composite::none{});
+
+    ostringstream expected;
+    dump(doc, expected);
+
+    ostringstream actual;
+    {
+        json_writer w(actual);
+        walk(doc, w);
+    }
+
+    EXPECT_EQ(expected.str(), actual.str());
+}
+
+TEST(json_writer, raw_numbers) {
+    ostringstream stream;
+    {
+        json_writer w(stream);
+        ASSERT_TRUE(load(R"({"a": 0.1000, "b": 123456789012345678901234567890, "c": [1E+5, -0, 5e-324]})", w).is_ok());
+    }
+
+    EXPECT_EQ(R"({"a":0.1000,"b":123456789012345678901234567890,"c":[1E+5,-0,5e-324]})", stream.str());
+}
+
+TEST(json_writer, converts_invalid_numbers) {
+    ostringstream stream;
+    {
+        json_writer w(stream);
+        ASSERT_TRUE(load("[+5, 01]", w).is_ok());
+    }
+
+    EXPECT_EQ("[5,1]", stream.str());
+}
+
+} // namespace
+} // namespace kjson
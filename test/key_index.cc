@@ -0,0 +1,70 @@
+#include "key_index.hh"
+#include <composite/make.hh>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+using namespace composite;
+
+TEST(key_index, find) {
+    mapping m;
+    for(int i = 0; i < 1000; ++i) {
+        m.emplace("id" + to_string(i), make(i));
+    }
+
+    key_index index(m);
+    EXPECT_EQ(0u, index.memory_usage());
+    EXPECT_EQ(1000u, index.size());
+    EXPECT_LT(0u, index.memory_usage());
+
+    for(int i = 0; i < 1000; ++i) {
+        auto v = index.find("id" + to_string(i));
+        ASSERT_NE(nullptr, v);
+        EXPECT_EQ(i, v->to<int>());
+    }
+    EXPECT_EQ(nullptr, index.find("id1000"));
+    EXPECT_EQ(nullptr, index.find(""));
+}
+
+TEST(key_index, empty) {
+    mapping   m;
+    key_index index(m);
+    EXPECT_EQ(nullptr, index.find("a"));
+    EXPECT_EQ(0u, index.size());
+}
+
+TEST(key_index, load_indexed) {
+    string input = R"({"small": {"a": 1}, "table": {)";
+    for(int i = 0; i < 100; ++i) {
+        input += (i ? ", \"" : "\"") + to_string(i) + "\": [" + to_string(i) + "]";
+    }
+    input += "}}";
+
+    auto doc = load_indexed(input, 10).unwrap();
+    EXPECT_EQ(load(input).unwrap(), doc.root());
+    EXPECT_EQ(nullptr, doc.index(doc.root().as<mapping>()));
+
+    const document* table = nullptr;
+    for(auto&& kv : doc.root().as<mapping>()) {
+        if(kv.first == "table") {
+            table = &kv.second;
+        } else {
+            EXPECT_EQ(nullptr, doc.index(kv.second.as<mapping>()));
+        }
+    }
+    ASSERT_NE(nullptr, table);
+
+    auto index = doc.index(table->as<mapping>());
+    ASSERT_NE(nullptr, index);
+    EXPECT_EQ(100u, index->size());
+    EXPECT_EQ(load("[42]").unwrap(), *index->find("42"));
+    EXPECT_LT(index->memory_usage(), doc.memory_usage());
+
+    EXPECT_TRUE(load_indexed("{").is_err());
+}
+
+} // namespace
+} // namespace kjson
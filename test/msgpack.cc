@@ -0,0 +1,188 @@
+#include "msgpack.hh"
+#include "json_writer.hh"
+#include <composite/make.hh>
+#include <gtest/gtest.h>
+#include <limits>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+using namespace composite;
+
+string unhex(string_view hex) {
+    string result;
+    for(size_t i = 0; i + 1 < hex.size(); i += 2) {
+        result += static_cast<char>(stoi(string(hex.substr(i, 2)), nullptr, 16));
+    }
+    return result;
+}
+
+string encode(scalar_t v) {
+    ostringstream stream;
+    msgpack_writer(stream).scalar(move(v));
+    return stream.str();
+}
+
+struct msgpack_testcase {
+    string   hex;
+    document expected;
+};
+
+inline ostream& operator<<(ostream& o, msgpack_testcase const& tc) {
+    return o << tc.hex;
+}
+
+class msgpack_decode_test : public testing::TestWithParam<msgpack_testcase> {
+};
+
+TEST_P(msgpack_decode_test, decode) {
+    auto actual = load_msgpack(unhex(GetParam().hex));
+
+    ASSERT_TRUE(actual.is_ok());
+    EXPECT_EQ(GetParam().expected, actual.unwrap());
+}
+
+msgpack_testcase msgpack_testcases[] = {
+    {"00", make(0u)},
+    {"7f", make(127u)},
+    {"cc80", make(128u)},
+    {"cd0100", make(256u)},
+    {"ce00010000", make(65536u)},
+    {"cfffffffffffffffff", make(numeric_limits<uint64_t>::max())},
+    {"ff", make(-1)},
+    {"e0", make(-32)},
+    {"d0df", make(-33)},
+    {"d1ff7f", make(-129)},
+    {"d2ffff7fff", make(-32769)},
+    {"d38000000000000000", make(numeric_limits<int64_t>::min())},
+    {"ca3fc00000", make(1.5)},
+    {"cb3ff8000000000000", make(1.5)},
+    {"c0", make(::composite::none{})},
+    {"c2", make(false)},
+    {"c3", make(true)},
+    {"a0", make("")},
+    {"a3666f6f", make("foo")},
+    {"d903666f6f", make("foo")},
+    {"da0003666f6f", make("foo")},
+    {"c403666f6f", make("foo")},
+    {"90", make_seq()},
+    {"920102", make_seq(1u, 2u)},
+    {"dc0002c3c2", make_seq(true, false)},
+    {"dd000000020190", make_seq(1u, make_seq())},
+    {"80", make_map()},
+    {"82a16101a16292c0a0", make_map("a", 1u, "b", make_seq(::composite::none{}, ""))},
+    {"df00000001a16101", make_map("a", 1u)},
+};
+
+INSTANTIATE_TEST_SUITE_P(msgpack_decode_tests,
+                         msgpack_decode_test,
+                         testing::ValuesIn(msgpack_testcases));
+
+TEST(msgpack, encode_scalars) {
+    EXPECT_EQ(unhex("00"), encode(uint64_t{0}));
+    EXPECT_EQ(unhex("7f"), encode(int64_t{127}));
+    EXPECT_EQ(unhex("cc80"), encode(uint64_t{128}));
+    EXPECT_EQ(unhex("cd0100"), encode(uint64_t{256}));
+    EXPECT_EQ(unhex("ce00010000"), encode(uint64_t{65536}));
+    EXPECT_EQ(unhex("cf0000000100000000"), encode(uint64_t{0x100000000}));
+    EXPECT_EQ(unhex("ff"), encode(int64_t{-1}));
+    EXPECT_EQ(unhex("e0"), encode(int64_t{-32}));
+    EXPECT_EQ(unhex("d0df"), encode(int64_t{-33}));
+    EXPECT_EQ(unhex("d1ff7f"), encode(int64_t{-129}));
+    EXPECT_EQ(unhex("d38000000000000000"), encode(numeric_limits<int64_t>::min()));
+    EXPECT_EQ(unhex("cb3ff8000000000000"), encode(1.5));
+    EXPECT_EQ(unhex("c0"), encode(none{}));
+    EXPECT_EQ(unhex("c3"), encode(true));
+    EXPECT_EQ(unhex("a3666f6f"), encode(string("foo")));
+    EXPECT_EQ(unhex("d920") + string(32, 'x'), encode(string(32, 'x')));
+}
+
+TEST(msgpack, encode_containers) {
+    ostringstream  stream;
+    msgpack_writer w(stream);
+    w.push_mapping();
+    w.scalar("a", uint64_t{1});
+    w.push_sequence("b");
+    w.scalar(uint64_t{2});
+    w.push_mapping();
+    w.pop();
+    w.pop();
+
+    EXPECT_TRUE(stream.str().empty());
+    w.pop();
+
+    EXPECT_EQ(unhex("df00000002a16101a162dd0000000202df00000000"), stream.str());
+}
+
+TEST(msgpack, round_trip) {
+    auto doc = make_map("key", "value", "list", make_seq("string", -1, true, make_map("pi", 3.14, "e", 2.71)), "none", ::composite::none{});
+
+    stringstream stream;
+    dump_msgpack(doc, stream);
+
+    EXPECT_EQ(doc, load_msgpack(stream).unwrap());
+}
+
+TEST(msgpack, to_json) {
+    ostringstream out;
+    json_writer   w(out);
+
+    ASSERT_TRUE(load_msgpack(unhex("82a16101a16292c0a0"), w).is_ok());
+    EXPECT_EQ(R"({"a":1,"b":[null,""]})", out.str());
+}
+
+TEST(msgpack, bin) {
+    ostringstream out;
+    json_writer   w(out);
+
+    ASSERT_TRUE(load_msgpack(unhex("81a164c403666f6f"), w).is_ok());
+    EXPECT_EQ(R"({"d":"Zm9v"})", out.str());
+
+    ostringstream encoded;
+    string        data = "foo";
+    msgpack_writer(encoded).binary(reinterpret_cast<const byte*>(data.data()), data.size());
+    EXPECT_EQ(unhex("c403666f6f"), encoded.str());
+}
+
+TEST(msgpack, errors) {
+    EXPECT_TRUE(load_msgpack(unhex("")).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("cd01")).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("920102ff")).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("8101a0")).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("c1")).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("c7")).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("a3666f")).is_err());
+
+    // NaN and infinity can not be dumped as json
+    EXPECT_TRUE(load_msgpack(unhex("ca7fc00000")).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("cbfff0000000000000")).is_err());
+
+    // nesting is limited by the input, not the call stack
+    ostringstream out;
+    json_writer   w(out);
+    EXPECT_TRUE(load_msgpack(string(2000000, '\x91') + '\xc0', w).is_ok());
+    EXPECT_TRUE(load_msgpack(string(2000000, '\x91'), w).is_err());
+
+    limits l;
+    l.max_depth = 100;
+    EXPECT_TRUE(load_msgpack(string(101, '\x91') + '\xc0', w, l).is_err());
+    EXPECT_TRUE(load_msgpack(string(100, '\x91') + '\xc0', l).is_ok());
+
+    l             = limits{};
+    l.max_members = 2;
+    EXPECT_TRUE(load_msgpack(unhex("93010203"), l).is_err());
+    EXPECT_TRUE(load_msgpack(unhex("920102"), l).is_ok());
+
+    l            = limits{};
+    l.max_string = 2;
+    EXPECT_TRUE(load_msgpack(unhex("a3616263"), l).is_err());
+
+    l           = limits{};
+    l.max_nodes = 2;
+    EXPECT_TRUE(load_msgpack(unhex("920102"), l).is_err());
+}
+
+} // namespace
+} // namespace kjson
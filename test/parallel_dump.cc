@@ -0,0 +1,83 @@
+#include "parallel_dump.hh"
+#include <composite/make.hh>
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+using namespace composite;
+
+string serial(const document& doc, bool compact) {
+    ostringstream stream;
+    dump(doc, stream, compact);
+    return stream.str();
+}
+
+string parallel(const document& doc, bool compact, size_t concurrency) {
+    ostringstream stream;
+    parallel_dump(doc, stream, compact, concurrency);
+    return stream.str();
+}
+
+document large_sequence() {
+    auto seq = sequence();
+    for(int i = 0; i < 100; ++i) {
+        seq.push_back(make_map("i", i, "list", make_seq(i, "s", make_seq()), "m", make_map()));
+        seq.push_back(make(i * 1.5));
+        seq.push_back(make_seq());
+    }
+    return document(move(seq));
+}
+
+document large_mapping() {
+    auto m = mapping();
+    for(int i = 0; i < 100; ++i) {
+        m.insert(make_pair("k" + to_string(i), make_seq(i, make_map("x", i, "y", make_seq()))));
+        m.insert(make_pair("s" + to_string(i), make("value")));
+    }
+    return document(move(m));
+}
+
+class parallel_dump_test : public testing::TestWithParam<size_t> {
+};
+
+TEST_P(parallel_dump_test, sequence_matches_serial) {
+    auto doc = large_sequence();
+
+    EXPECT_EQ(serial(doc, true), parallel(doc, true, GetParam()));
+    EXPECT_EQ(serial(doc, false), parallel(doc, false, GetParam()));
+}
+
+TEST_P(parallel_dump_test, mapping_matches_serial) {
+    auto doc = large_mapping();
+
+    EXPECT_EQ(serial(doc, true), parallel(doc, true, GetParam()));
+    EXPECT_EQ(serial(doc, false), parallel(doc, false, GetParam()));
+}
+
+TEST_P(parallel_dump_test, small_documents) {
+    document docs[] = {
+        make(1),
+        make("s"),
+        make_seq(),
+        make_map(),
+        make_seq(1),
+        make_map("a", 1),
+        make_seq(1, 2),
+        make_map("a", make_seq(), "b", make_map()),
+    };
+
+    for(auto&& doc : docs) {
+        EXPECT_EQ(serial(doc, true), parallel(doc, true, GetParam()));
+        EXPECT_EQ(serial(doc, false), parallel(doc, false, GetParam()));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(parallel_dump_tests,
+                         parallel_dump_test,
+                         testing::Values(0, 1, 2, 3, 7, 1000));
+
+} // namespace
+} // namespace kjson
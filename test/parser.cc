@@ -2,6 +2,7 @@
 #include <composite/make.hh>
 #include <gtest/gtest.h>
 #include <sstream>
+#include <vector>
 
 namespace kjson {
 namespace {
@@ -162,5 +163,37 @@ TEST(parser, bad_values) {
     EXPECT_TRUE(parse(stream, v).is_err());
 }
 
+class binary_visitor : public to_composite {
+  public:
+    bool expect_binary(string_view key) override {
+        return key == "blob";
+    }
+
+    void binary(string_view key, const std::byte* data, std::size_t size) override {
+        d_blobs.emplace_back(reinterpret_cast<const char*>(data), size);
+        to_composite::binary(key, data, size);
+    }
+
+    vector<string> d_blobs;
+};
+
+TEST(parser, binary) {
+    binary_visitor v;
+    istringstream  stream(R"({"name": "Zm9v", "blob": "Zm9vYg==", "more": {"blob": "P\/8="}})");
+    ASSERT_TRUE(parse(stream, v).is_ok());
+
+    EXPECT_EQ((vector<string>{"foob", "?\xff"}), v.d_blobs);
+
+    EXPECT_EQ(parse("{\"name\": \"Zm9v\", \"blob\": \"foob\", \"more\": {\"blob\": \"?\xff\"}}"), v.collect());
+}
+
+TEST(parser, bad_binary) {
+    for(auto input : {R"({"blob": "Zm9v!"})", R"({"blob": "Zm9vY"})", R"({"blob": "Zm9v)", R"({"blob": "\n"})"}) {
+        binary_visitor v;
+        istringstream  stream(input);
+        EXPECT_TRUE(parse(stream, v).is_err()) << input;
+    }
+}
+
 } // namespace
 } // namespace kjson
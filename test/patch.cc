@@ -0,0 +1,90 @@
+#include "patch.hh"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+document doc(string_view json) {
+    return load(json).unwrap();
+}
+
+string patched(string_view input, string_view patch, patch_format format = patch_format::e_json_patch) {
+    ostringstream out;
+    apply_patch(input, doc(patch), out, format).unwrap();
+    return out.str();
+}
+
+struct patch_testcase {
+    string input;
+    string patch;
+    string output;
+};
+
+inline ostream& operator<<(ostream& o, patch_testcase const& tc) {
+    return o << tc.input << " + " << tc.patch;
+}
+
+class apply_json_patch_test : public testing::TestWithParam<patch_testcase> {
+};
+
+TEST_P(apply_json_patch_test, apply) {
+    EXPECT_EQ(GetParam().output, patched(GetParam().input, GetParam().patch));
+}
+
+INSTANTIATE_TEST_SUITE_P(apply_patch, apply_json_patch_test, testing::Values(patch_testcase{R"({"a": 1, "b": [1, 2]})", "[]", R"({"a":1,"b":[1,2]})"}, patch_testcase{"1", R"([{"op": "replace", "path": "", "value": [2]}])", "[2]"}, patch_testcase{R"({"a": 1, "b": 2})", R"([{"op": "remove", "path": "/a"}, {"op": "replace", "path": "/b", "value": 3}, {"op": "add", "path": "/c", "value": [4]}])", R"({"b":3,"c":[4]})"}, patch_testcase{R"({"x": {"y": {"z": 1, "w": "a \"q\""}}, "big": [1, 2, 3]})", R"([{"op": "replace", "path": "/x/y/z", "value": 5}])", R"({"x":{"y":{"z":5,"w":"a \"q\""}},"big":[1,2,3]})"}, patch_testcase{"[1, 2, 3, 4]", R"([{"op": "remove", "path": "/2"}, {"op": "remove", "path": "/1"}])", "[1,4]"}, patch_testcase{"[1, 4]", R"([{"op": "add", "path": "/1", "value": 2}, {"op": "add", "path": "/2", "value": 3}])", "[1,2,3,4]"}, patch_testcase{"[1, 2]", R"([{"op": "add", "path": "/-", "value": 3}, {"op": "add", "path": "/0", "value": 0}])", "[0,1,2,3]"}, patch_testcase{"[[1], [2]]", R"([{"op": "add", "path": "/1/0", "value": 0}, {"op": "remove", "path": "/0"}])", "[[0,2]]"}, patch_testcase{R"({"a/b": 1, "c~d": 2})", R"([{"op": "replace", "path": "/a~1b", "value": 2}, {"op": "replace", "path": "/c~0d", "value": 3}])", R"({"a/b":2,"c~d":3})"}, patch_testcase{R"({"ké": 1})", R"([{"op": "replace", "path": "/ké", "value": 2}])", R"({"ké":2})"}, patch_testcase{R"({"a": 1})", R"([{"op": "remove", "path": "/a"}, {"op": "add", "path": "/a", "value": {"b": 2}}])", R"({"a":{"b":2}})"}, patch_testcase{"{}", R"([{"op": "add", "path": "/a", "value": 1}])", R"({"a":1})"}));
+
+class apply_merge_patch_test : public testing::TestWithParam<patch_testcase> {
+};
+
+TEST_P(apply_merge_patch_test, apply) {
+    EXPECT_EQ(GetParam().output, patched(GetParam().input, GetParam().patch, patch_format::e_merge_patch));
+}
+
+INSTANTIATE_TEST_SUITE_P(apply_patch, apply_merge_patch_test, testing::Values(patch_testcase{R"({"a": 1})", "{}", R"({"a":1})"}, patch_testcase{R"({"a": 1, "b": 2})", R"({"a": null, "b": 3, "c": 4})", R"({"b":3,"c":4})"}, patch_testcase{R"({"x": {"y": 1, "z": 2}, "s": [1]})", R"({"x": {"z": 3}})", R"({"x":{"y":1,"z":3},"s":[1]})"}, patch_testcase{"[1, 2]", "[1, 3]", "[1,3]"}, patch_testcase{R"({"a": [1]})", R"({"a": {"b": 1, "c": null}})", R"({"a":{"b":1}})"}, patch_testcase{R"({"a": 1})", R"({"b": {"c": null, "d": 1}})", R"({"a":1,"b":{"d":1}})"}));
+
+TEST(apply_patch, diff_round_trip) {
+    const char* pairs[][2] = {
+        {R"({"a": 1, "b": [1, 2, 3], "c": {"d": "e"}})", R"({"b": [1, 3, 4], "c": {"d": "f", "g": []}})"},
+        {"[1, 2, 3, 4, 5]", "[0, 2, 5, 6]"},
+        {R"({"x": [{"y": 1}, {"y": 2}]})", R"({"x": [{"y": 1}, {"y": 3, "z": []}]})"},
+    };
+
+    for(auto&& p : pairs) {
+        for(auto format : {patch_format::e_json_patch, patch_format::e_merge_patch}) {
+            ostringstream out;
+            ASSERT_TRUE(apply_patch(p[0], diff(doc(p[0]), doc(p[1]), format), out, format).is_ok());
+            EXPECT_EQ(doc(p[1]), doc(out.str())) << p[0] << " -> " << p[1];
+        }
+    }
+}
+
+TEST(apply_patch, stream) {
+    istringstream in(R"({"a": [1, 2], "b": true})");
+    ostringstream out;
+    ASSERT_TRUE(apply_patch(in, doc(R"([{"op": "remove", "path": "/a/0"}])"), out).is_ok());
+    EXPECT_EQ(R"({"a":[2],"b":true})", out.str());
+}
+
+TEST(apply_patch, errors) {
+    auto fails = [](string_view input, string_view patch) {
+        ostringstream out;
+        return apply_patch(input, doc(patch), out).is_err();
+    };
+
+    EXPECT_TRUE(fails(R"({"a": 1})", R"([{"op": "remove", "path": "/b"}])"));
+    EXPECT_TRUE(fails(R"({"a": 1})", R"([{"op": "replace", "path": "/a/b", "value": 1}])"));
+    EXPECT_TRUE(fails("[1]", R"([{"op": "remove", "path": "/1"}])"));
+    EXPECT_TRUE(fails("[1]", R"([{"op": "remove", "path": "/x"}])"));
+    EXPECT_TRUE(fails("{}", R"([{"op": "move", "from": "/a", "path": "/b"}])"));
+    EXPECT_TRUE(fails("{}", R"([{"op": "add", "path": "/a"}])"));
+    EXPECT_TRUE(fails("{}", R"([{"op": "add", "path": "/a", "value": {}}, {"op": "add", "path": "/a/b", "value": 1}])"));
+    EXPECT_TRUE(fails("{}", R"({"op": "add"})"));
+    EXPECT_TRUE(fails(R"({"a": 1)", R"([{"op": "replace", "path": "/a", "value": 2}])"));
+    EXPECT_TRUE(fails("{} {}", "[]"));
+}
+
+} // namespace
+} // namespace kjson
@@ -0,0 +1,94 @@
+#include "query.hh"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+const char* orders = R"({
+    "store": "north",
+    "orders": [
+        {"id": 1, "price": 5.5, "customer": {"name": "ann"}, "tags": ["a"]},
+        {"id": 2, "price": 12, "customer": {"name": "bob"}, "paid": true},
+        {"id": 3, "price": 30, "customer": {"name": "cy"}, "paid": false}
+    ]
+})";
+
+string run(string_view expression, string_view input = orders) {
+    auto          q = query::compile(expression).unwrap();
+    ostringstream out;
+    auto          r = filter(input, q, out);
+    EXPECT_TRUE(r.is_ok()) << expression;
+    return out.str();
+}
+
+TEST(query, identity) {
+    EXPECT_EQ("[1,{\"a\":2}]\n", run(".", "[1, {\"a\": 2}]"));
+}
+
+TEST(query, paths) {
+    EXPECT_EQ("\"north\"\n", run(".store"));
+    EXPECT_EQ("2\n", run(".orders[1].id"));
+    EXPECT_EQ("\"cy\"\n", run(".orders.[2].customer.name"));
+    EXPECT_EQ("\"north\"\n", run(R"(.["store"])"));
+    EXPECT_EQ("", run(".missing"));
+}
+
+TEST(query, raw_numbers) {
+    EXPECT_EQ("0.10\n12345678901234567890123\n", run(".[]", "[0.10, 12345678901234567890123]"));
+    EXPECT_EQ("0.5\n", run(".[] | select(. < 1)", "[0.50, 2]"));
+}
+
+TEST(query, iterate) {
+    EXPECT_EQ("1\n2\n3\n", run(".orders[].id"));
+    EXPECT_EQ("\"ann\"\n\"bob\"\n\"cy\"\n", run(".orders[] | .customer | .name"));
+    EXPECT_EQ("1\n2\n", run(".[]", R"({"a": 1, "b": 2})"));
+    EXPECT_EQ("[\"a\"]\n", run(".orders[].tags"));
+}
+
+TEST(query, select) {
+    EXPECT_EQ("2\n3\n", run(".orders[] | select(.price > 10) | .id"));
+    EXPECT_EQ("2\n", run(".orders[] | select(.price > 10 and .paid) | .id"));
+    EXPECT_EQ("1\n2\n", run(".orders[] | select(.customer.name == \"ann\" or .paid == true) | .id"));
+    EXPECT_EQ("1\n", run(".orders[] | select(.price <= 5.5) | .id"));
+    EXPECT_EQ("1\n3\n", run(".orders[] | select(.paid != true) | .id"));
+    EXPECT_EQ("", run(".orders[] | select(.price < \"x\") | .id"));
+}
+
+TEST(query, project) {
+    EXPECT_EQ("{\"id\":2,\"who\":\"bob\"}\n{\"id\":3,\"who\":\"cy\"}\n",
+              run(".orders[] | select(.price >= 12) | {id, who: .customer.name}"));
+    EXPECT_EQ("{\"paid\":null}\n", run(".orders[0] | {paid}"));
+}
+
+TEST(query, pretty) {
+    auto          q = query::compile(".a").unwrap();
+    ostringstream out;
+    ASSERT_TRUE(filter(R"({"a": [1]})", q, out, false).is_ok());
+    EXPECT_EQ("[\n  1\n]\n", out.str());
+}
+
+TEST(query, stream) {
+    string input = "[";
+    for(int i = 0; i < 1000; ++i) {
+        input += (i ? "," : "") + string(R"({"n": )") + to_string(i) + "}";
+    }
+    input += "]";
+
+    auto          q = query::compile(".[] | select(.n >= 998) | .n").unwrap();
+    istringstream in(input);
+    ostringstream out;
+    ASSERT_TRUE(filter(in, q, out).is_ok());
+    EXPECT_EQ("998\n999\n", out.str());
+}
+
+TEST(query, bad_expressions) {
+    for(auto expression : {"", "a", ".a |", ".[", ".[x]", "select(.a ==)", "{a", ".a b", "select(.a"}) {
+        EXPECT_TRUE(query::compile(expression).is_err()) << expression;
+    }
+}
+
+} // namespace
+} // namespace kjson
@@ -0,0 +1,110 @@
+#include "reader.hh"
+#include "stats/allocations.hh"
+#include "visitor.hh"
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+TEST(reader, reused) {
+    reader r;
+    for(auto input : {R"({"a": [1, -2, 3.5], "b": {"c": "long enough to need the heap"}})", "[]", R"("x")", R"({"a": [1, -2, 3.5], "b": null})"}) {
+        EXPECT_EQ(load(input).unwrap(), r.load(input).unwrap()) << input;
+    }
+
+    istringstream stream(R"([true, false])");
+    EXPECT_EQ(load("[true, false]").unwrap(), r.load(stream).unwrap());
+}
+
+TEST(reader, error_then_ok) {
+    reader r;
+    EXPECT_TRUE(r.load(R"({"a": [1, 2)").is_err());
+    EXPECT_TRUE(r.load("{1}").is_err());
+    EXPECT_EQ(load(R"({"a": 1})").unwrap(), r.load(R"({"a": 1})").unwrap());
+}
+
+TEST(reader, resource) {
+    // the buffers grow within the arena and are kept for the next load
+    char                                buffer[64 * 1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+    reader r(&arena);
+    auto   input = R"({"a key that needs the heap": ["a value that needs the heap", "\u00e9"]})";
+    for(int i = 0; i < 3; ++i) {
+        EXPECT_EQ(load(input).unwrap(), r.load(input).unwrap());
+    }
+}
+
+TEST(reader, limits) {
+    limits l;
+    l.max_members = 1;
+
+    reader r(l);
+    EXPECT_TRUE(r.load("[1, 2]").is_err());
+    EXPECT_TRUE(r.load("[[1], [2]]").is_err());
+    EXPECT_EQ(load("[[1]]").unwrap(), r.load("[[1]]").unwrap());
+}
+
+class depth_visitor : public visitor {
+  public:
+    void scalar(scalar_t) override {
+    }
+    void scalar(string_view, scalar_t) override {
+    }
+    void push_sequence() override {
+        d_max = max(d_max, ++d_depth);
+    }
+    void push_sequence(string_view) override {
+        push_sequence();
+    }
+    void push_mapping() override {
+        d_max = max(d_max, ++d_depth);
+    }
+    void push_mapping(string_view) override {
+        push_mapping();
+    }
+    void pop() override {
+        --d_depth;
+    }
+
+    size_t d_depth{0};
+    size_t d_max{0};
+};
+
+TEST(reader, deep_nesting) {
+    const size_t depth = 100000;
+    string       input = string(depth, '[') + string(depth, ']');
+
+    reader        r;
+    depth_visitor v;
+    ASSERT_TRUE(r.load(input, v).is_ok());
+    EXPECT_EQ(depth, v.d_max);
+    EXPECT_EQ(0u, v.d_depth);
+}
+
+#ifdef KJSON_STATS
+// counted by kjson_allocations, which the test links with KJSON_STATS
+TEST(reader, no_steady_state_allocations) {
+    auto input = R"({"a key longer than the small string buffer": [1, -2, 3.5, "short", {"b": null, "c": [true]}]})";
+
+    // the key is swapped with the token buffer, so both have grown after two loads
+    reader        r;
+    depth_visitor v;
+    ASSERT_TRUE(r.load(input, v).is_ok());
+    ASSERT_TRUE(r.load(input, v).is_ok());
+
+    auto before = allocation_count::now();
+    for(int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(r.load(input, v).is_ok());
+    }
+    EXPECT_EQ(before.count, allocation_count::now().count);
+}
+#endif
+
+} // namespace
+} // namespace kjson
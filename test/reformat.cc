@@ -0,0 +1,78 @@
+#include "json.hh"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+string minified(string_view input) {
+    ostringstream out;
+    EXPECT_TRUE(minify(input, out).is_ok()) << input;
+    return out.str();
+}
+
+string prettified(string_view input, size_t indent = 2) {
+    ostringstream out;
+    EXPECT_TRUE(prettify(input, out, indent).is_ok()) << input;
+    return out.str();
+}
+
+TEST(reformat, minify) {
+    EXPECT_EQ(R"({"a":[1,2.50,-3e+10],"b":{"c":null,"d":true}})",
+              minified(" { \"a\" : [ 1 ,\n 2.50, -3e+10 ] ,\t\"b\":{ \"c\" : null , \"d\" :true } }\n"));
+}
+
+TEST(reformat, scalars) {
+    EXPECT_EQ("1.000", minified(" 1.000 "));
+    EXPECT_EQ(R"("a b")", minified(R"( "a b" )"));
+    EXPECT_EQ("null", minified("null"));
+}
+
+TEST(reformat, strings_are_copied_verbatim) {
+    EXPECT_EQ(R"(["a \" , b","\\","\u00e9 \n"])", minified(R"([ "a \" , b" , "\\" , "\u00e9 \n" ])"));
+}
+
+TEST(reformat, prettify) {
+    EXPECT_EQ(R"({
+  "a": [
+    1,
+    2
+  ],
+  "b": {},
+  "c": []
+})",
+              prettified(R"({"a":[1,2],"b":{ },"c":[]})"));
+}
+
+TEST(reformat, prettify_indent) {
+    EXPECT_EQ("[\n    [\n        1\n    ]\n]", prettified("[[1]]", 4));
+}
+
+TEST(reformat, roundtrip) {
+    string input = R"({"s":"x y","n":[1.10,{"k":[[],{}]}]})";
+    EXPECT_EQ(input, minified(prettified(input)));
+}
+
+TEST(reformat, stream) {
+    string input(200000, ' ');
+    input.front() = '[';
+    input.back()  = ']';
+    input.insert(100000, "\"spanning a chunk boundary\"");
+
+    istringstream in(input);
+    ostringstream out;
+    ASSERT_TRUE(minify(in, out).is_ok());
+    EXPECT_EQ(R"(["spanning a chunk boundary"])", out.str());
+}
+
+TEST(reformat, errors) {
+    for(auto input : {"", "[1 2]", "{\"a\" 1}", "{1: 2}", "[1,]", "[1}", "\"open", "[", "1 2", "{\"a\":1,}", "[#]"}) {
+        ostringstream out;
+        EXPECT_TRUE(minify(input, out).is_err()) << input;
+    }
+}
+
+} // namespace
+} // namespace kjson
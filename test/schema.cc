@@ -0,0 +1,178 @@
+#include "schema.hh"
+#include "json_writer.hh"
+#include "parser.hh"
+#include <composite/make.hh>
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+const char* person = R"({
+    "type": "object",
+    "required": ["name", "age"],
+    "properties": {
+        "name": {"type": "string", "minLength": 1, "maxLength": 4},
+        "age": {"type": "integer", "minimum": 0, "maximum": 150},
+        "role": {"enum": ["admin", "user", null]},
+        "score": {"type": "number", "exclusiveMaximum": 1},
+        "tags": {"type": "array", "maxItems": 2, "items": {"type": "string"}},
+        "nested": {"type": "object", "required": ["id"]}
+    }
+})";
+
+schema compiled(string_view definition) {
+    return schema::parse(definition).unwrap();
+}
+
+TEST(schema, valid) {
+    auto s = compiled(person);
+
+    for(auto input : {
+            R"({"name": "Ann", "age": 30})",
+            R"({"name": "éééé", "age": 0, "role": null})",
+            R"({"name": "Bob", "age": 150.0, "score": 0.5, "tags": ["a", "b"], "extra": [1, {"x": 2}]})",
+            R"({"age": 1, "name": "Al", "nested": {"id": 1, "other": true}, "role": "admin"})",
+        }) {
+        auto r = validate(input, s);
+        EXPECT_TRUE(r.is_ok()) << input;
+    }
+}
+
+struct violation_testcase {
+    string input;
+};
+
+inline ostream& operator<<(ostream& o, violation_testcase const& tc) {
+    return o << tc.input;
+}
+
+class schema_violation_test : public testing::TestWithParam<violation_testcase> {
+};
+
+TEST_P(schema_violation_test, invalid) {
+    auto s = compiled(person);
+    EXPECT_TRUE(validate(GetParam().input, s).is_err());
+}
+
+INSTANTIATE_TEST_SUITE_P(schema, schema_violation_test, testing::Values(violation_testcase{R"([])"}, violation_testcase{R"({"name": "Ann"})"}, violation_testcase{R"({"name": 1, "age": 1})"}, violation_testcase{R"({"name": "", "age": 1})"}, violation_testcase{R"({"name": "Annie", "age": 1})"}, violation_testcase{R"({"name": "Ann", "age": -1})"}, violation_testcase{R"({"name": "Ann", "age": 1.5})"}, violation_testcase{R"({"name": "Ann", "age": 151})"}, violation_testcase{R"({"name": "Ann", "age": 1, "role": "root"})"}, violation_testcase{R"({"name": "Ann", "age": 1, "score": 1})"}, violation_testcase{R"({"name": "Ann", "age": 1, "tags": ["a", 1]})"}, violation_testcase{R"({"name": "Ann", "age": 1, "tags": ["a", "b", "c"]})"}, violation_testcase{R"({"name": "Ann", "age": 1, "nested": {}})"}, violation_testcase{R"({"name": "Ann", "age": 1, "nested": []})"}));
+
+// records the events that made it through the validator
+class counting_visitor : public to_composite {
+  public:
+    void scalar(string_view key, scalar_t v) override {
+        ++d_scalars;
+        to_composite::scalar(key, move(v));
+    }
+
+    size_t d_scalars{0};
+};
+
+TEST(schema, stops_at_first_violation) {
+    auto s = compiled(R"({"type": "object", "properties": {"b": {"type": "string"}}})");
+
+    counting_visitor next;
+    schema_validator v(s, next);
+    EXPECT_TRUE(load(R"({"a": 1, "b": 2, "c": 3})", v).is_err());
+    EXPECT_EQ(1u, next.d_scalars);
+}
+
+TEST(schema, forwards) {
+    auto s = compiled(R"({"type": "array", "items": {"type": "integer"}})");
+
+    to_composite     next;
+    schema_validator v(s, next);
+    ASSERT_TRUE(load("[1, 2, 3]", v).is_ok());
+    EXPECT_EQ(load("[1, 2, 3]").unwrap(), next.collect());
+}
+
+class binary_writer : public json_writer {
+  public:
+    using json_writer::json_writer;
+
+    bool expect_binary(string_view key) override {
+        return key == "b";
+    }
+};
+
+TEST(schema, forwards_binary) {
+    auto s = compiled(R"({"properties": {"b": {"type": "string", "maxLength": 3}}})");
+
+    ostringstream    out;
+    binary_writer    next(out);
+    schema_validator v(s, next);
+    ASSERT_TRUE(load(R"({"b": "AAEC"})", v).is_ok());
+    EXPECT_EQ(R"({"b":"AAEC"})", out.str());
+
+    EXPECT_TRUE(load(R"({"b": "AAECAw=="})", v).is_err());
+}
+
+TEST(schema, forwards_numbers_verbatim) {
+    auto s = compiled(R"({"items": {"type": "number", "maximum": 2}})");
+
+    ostringstream    out;
+    json_writer      next(out);
+    schema_validator v(s, next);
+    ASSERT_TRUE(load("[1.10, 1e0, -0.0]", v).is_ok());
+    EXPECT_EQ("[1.10,1e0,-0.0]", out.str());
+
+    EXPECT_TRUE(load("[2.5]", v).is_err());
+}
+
+TEST(schema, error_location) {
+    auto s = compiled(R"({"properties": {"a": {"items": {"properties": {"b": {"type": "string"}}}}}})");
+
+    schema_validator v(s);
+    try {
+        v.push_mapping();
+        v.push_sequence("a");
+        v.push_mapping();
+        v.pop();
+        v.push_mapping();
+        v.scalar("b", int64_t{1});
+        FAIL() << "expected a violation";
+    } catch(const schema_error& e) {
+        EXPECT_EQ(string("/a/1/b: unexpected a number"), e.what());
+    }
+}
+
+TEST(schema, inclusive_and_exclusive_bounds) {
+    for(auto definition : {R"({"minimum": 5, "exclusiveMinimum": 0, "maximum": 10, "exclusiveMaximum": 20})",
+                           R"({"exclusiveMaximum": 20, "exclusiveMinimum": 0, "maximum": 10, "minimum": 5})"}) {
+        auto s = compiled(definition);
+        EXPECT_TRUE(validate("5", s).is_ok()) << definition;
+        EXPECT_TRUE(validate("10", s).is_ok()) << definition;
+        EXPECT_TRUE(validate("4", s).is_err()) << definition;
+        EXPECT_TRUE(validate("11", s).is_err()) << definition;
+    }
+
+    auto s = compiled(R"({"minimum": 0, "exclusiveMinimum": 5, "exclusiveMaximum": 10, "maximum": 20})");
+    EXPECT_TRUE(validate("5", s).is_err());
+    EXPECT_TRUE(validate("6", s).is_ok());
+    EXPECT_TRUE(validate("10", s).is_err());
+}
+
+TEST(schema, compile_from_document) {
+    auto definition = load(R"({"type": ["string", "null"]})").unwrap();
+    auto s          = schema::compile(definition).unwrap();
+
+    EXPECT_TRUE(validate("null", s).is_ok());
+    EXPECT_TRUE(validate(R"("x")", s).is_ok());
+    EXPECT_TRUE(validate("1", s).is_err());
+}
+
+TEST(schema, accepts_anything) {
+    auto s = compiled("{}");
+    EXPECT_TRUE(validate(R"({"a": [1, "x", null]})", s).is_ok());
+}
+
+TEST(schema, bad_definitions) {
+    for(auto definition : {"[]", R"({"type": "thing"})", R"({"minLength": -1})", R"({"required": [1]})", R"({"items": 1})", R"({"enum": [[1]]})", "{"}) {
+        EXPECT_TRUE(schema::parse(definition).is_err()) << definition;
+    }
+}
+
+} // namespace
+} // namespace kjson
@@ -0,0 +1,142 @@
+#include "snapshot.hh"
+#include "json_writer.hh"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <unistd.h>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+class snapshot_test : public testing::Test {
+  protected:
+    void SetUp() override {
+        char name[] = "/tmp/kjson_snapshot_XXXXXX";
+        int  fd     = mkstemp(name);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        d_path = name;
+    }
+
+    void TearDown() override {
+        remove(d_path.c_str());
+    }
+
+    snapshot roundtrip(string_view json) {
+        auto data = load(json).unwrap();
+        EXPECT_TRUE(save_snapshot(data, d_path).is_ok());
+        return open_snapshot(d_path).unwrap();
+    }
+
+    string d_path;
+};
+
+TEST_F(snapshot_test, scalars) {
+    auto s    = roundtrip(R"([null, true, -3, 18446744073709551615, 1.5, "hello"])");
+    auto root = s.root();
+
+    using type_t = snapshot::value::type_t;
+    ASSERT_EQ(type_t::e_sequence, root.type());
+    ASSERT_EQ(6u, root.size());
+    EXPECT_EQ(type_t::e_none, root[0].type());
+    EXPECT_TRUE(root[1].as_bool());
+    EXPECT_EQ(-3, root[2].as_int());
+    EXPECT_EQ(18446744073709551615u, root[3].as_uint());
+    EXPECT_DOUBLE_EQ(1.5, root[4].as_float());
+    EXPECT_EQ("hello", root[5].as_string());
+    EXPECT_THROW(root[6], out_of_range);
+    EXPECT_THROW(root[5].as_int(), snapshot_error);
+}
+
+TEST_F(snapshot_test, find) {
+    auto s    = roundtrip(R"({"zeta": 1, "alpha": {"nested": [1, 2]}, "mid": "x"})");
+    auto root = s.root();
+
+    ASSERT_EQ(3u, root.size());
+    EXPECT_EQ("alpha", root.key(0));
+    EXPECT_EQ("mid", root.key(1));
+    EXPECT_EQ("zeta", root.key(2));
+
+    auto zeta = root.find("zeta");
+    ASSERT_TRUE(zeta.has_value());
+    EXPECT_EQ(1u, zeta->as_uint());
+
+    auto nested = root.find("alpha")->find("nested");
+    ASSERT_TRUE(nested.has_value());
+    EXPECT_EQ(2u, (*nested)[1].as_uint());
+
+    EXPECT_FALSE(root.find("missing").has_value());
+    EXPECT_FALSE(root.find("").has_value());
+}
+
+TEST_F(snapshot_test, to_document) {
+    auto json = R"({"a": [1, "two", {"b": null}], "c": false, "d": "two"})";
+    auto s    = roundtrip(json);
+
+    EXPECT_EQ(load(json).unwrap(), s.root().to_document());
+}
+
+TEST_F(snapshot_test, walk) {
+    auto s = roundtrip(R"({"b": [1, 2], "a": "x"})");
+
+    ostringstream out;
+    {
+        json_writer w(out);
+        s.root().walk(w);
+    }
+    EXPECT_EQ(R"({"a":"x","b":[1,2]})", out.str());
+}
+
+TEST_F(snapshot_test, outlives_moves) {
+    auto s     = roundtrip(R"(["moved"])");
+    auto moved = move(s);
+    EXPECT_EQ("moved", moved.root()[0].as_string());
+}
+
+TEST_F(snapshot_test, replaces_mapped) {
+    auto before = roundtrip(R"(["before", 1])");
+    auto after  = roundtrip(R"(["after"])");
+
+    EXPECT_EQ("before", before.root()[0].as_string());
+    EXPECT_EQ(2u, before.root().size());
+    EXPECT_EQ("after", after.root()[0].as_string());
+
+    EXPECT_TRUE(save_snapshot(load("1").unwrap(), d_path + ".missing/file").is_err());
+}
+
+TEST_F(snapshot_test, missing_file) {
+    EXPECT_TRUE(open_snapshot(d_path + ".missing").is_err());
+}
+
+TEST_F(snapshot_test, not_a_snapshot) {
+    ofstream(d_path) << "{\"this is\": \"json\", \"not\": \"a snapshot at all\"}";
+    EXPECT_TRUE(open_snapshot(d_path).is_err());
+}
+
+TEST_F(snapshot_test, truncated) {
+    roundtrip(R"({"a": [1, 2, 3]})");
+    truncate(d_path.c_str(), 60);
+    EXPECT_TRUE(open_snapshot(d_path).is_err());
+}
+
+TEST_F(snapshot_test, cycle) {
+    roundtrip("[[1]]");
+
+    // point the root's items back at the root itself
+    {
+        fstream  f(d_path, ios::in | ios::out | ios::binary);
+        uint64_t root = 48;
+        f.seekp(56);
+        f.write(reinterpret_cast<const char*>(&root), sizeof(root));
+    }
+
+    auto s = open_snapshot(d_path).unwrap();
+    EXPECT_THROW(s.root()[0], snapshot_error);
+    EXPECT_THROW(s.root().to_document(), snapshot_error);
+}
+
+} // namespace
+} // namespace kjson
@@ -0,0 +1,87 @@
+#include "stats.hh"
+#include <composite/make.hh>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+// token::type_t order
+enum {
+    e_start_mapping,
+    e_end_mapping,
+    e_start_sequence,
+    e_end_sequence,
+    e_separator,
+    e_mapper,
+    e_string,
+    e_int,
+    e_uint,
+    e_float,
+    e_true,
+    e_false,
+    e_null,
+    e_eof,
+};
+
+TEST(stats, load) {
+    string input = R"({"a": [1, -2, 3.5, "x\"y"], "b": {"c": null, "d": true}})";
+
+    stats s;
+    auto  doc = load(input, s);
+    ASSERT_TRUE(doc.is_ok());
+    EXPECT_EQ(load(input).unwrap(), doc.unwrap());
+
+    if(!stats::enabled) {
+        EXPECT_EQ(0u, s.bytes);
+        EXPECT_EQ(0u, s.nodes);
+        EXPECT_EQ(0u, s.allocations);
+        return;
+    }
+
+    EXPECT_EQ(input.size(), s.bytes);
+    EXPECT_EQ(2u, s.tokens[e_start_mapping]);
+    EXPECT_EQ(1u, s.tokens[e_start_sequence]);
+    EXPECT_EQ(4u, s.tokens[e_mapper]);
+    EXPECT_EQ(5u, s.tokens[e_separator]);
+    EXPECT_EQ(5u, s.tokens[e_string]);
+    EXPECT_EQ(1u, s.tokens[e_int]);
+    EXPECT_EQ(1u, s.tokens[e_uint]);
+    EXPECT_EQ(1u, s.tokens[e_float]);
+    EXPECT_EQ(1u, s.tokens[e_null]);
+    EXPECT_EQ(1u, s.tokens[e_eof]);
+    EXPECT_EQ(2u, s.max_depth);
+    EXPECT_EQ(9u, s.nodes);
+    EXPECT_EQ(7u, s.string_bytes);
+    EXPECT_EQ(1u, s.escaped_strings);
+    EXPECT_LT(0u, s.allocations);
+    EXPECT_LT(0u, s.allocated_bytes);
+    EXPECT_LT(0, s.build.count());
+}
+
+TEST(stats, load_error) {
+    stats s;
+    EXPECT_TRUE(load(R"({"a": [1)", s).is_err());
+}
+
+TEST(stats, dump) {
+    auto doc = composite::make_map("a", composite::make_seq(1, "q\"uote"));
+
+    stats         s;
+    ostringstream out;
+    dump(doc, out, s);
+    EXPECT_EQ(R"({"a":[1,"q\"uote"]})", out.str());
+
+    if(stats::enabled) {
+        EXPECT_EQ(out.str().size(), s.bytes);
+        EXPECT_EQ(4u, s.nodes);
+        EXPECT_EQ(2u, s.max_depth);
+        EXPECT_EQ(1u, s.escaped_strings);
+    }
+}
+
+} // namespace
+} // namespace kjson
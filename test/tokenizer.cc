@@ -68,7 +68,10 @@ tokenizer_testcase tokenizer_testcases[] =
         {"\"\\n\"", {{token::type_t::e_string, "\n"}}},
         {"\"\\r\"", {{token::type_t::e_string, "\r"}}},
         {"\"\\t\"", {{token::type_t::e_string, "\t"}}},
-        {"\"\\ud582\"", {{token::type_t::e_string, "\xd5\x82"}}},
+        {"\"\\ud582\"", {{token::type_t::e_string, "\xed\x96\x82"}}},
+        {"\"\\u0041\\u00e9\\u20AC\"", {{token::type_t::e_string, "A\xc3\xa9\xe2\x82\xac"}}},
+        {"\"\\ud83d\\ude00\"", {{token::type_t::e_string, "\xf0\x9f\x98\x80"}}},
+        {"\"\\u0000\"", {{token::type_t::e_string, pmr::string(1, '\0')}}},
         {"\"noot\"", {{token::type_t::e_string, "noot"}}},
 
         // skip whitespace
@@ -92,6 +95,13 @@ TEST(tokenizer, invalid_utf8) {
     EXPECT_TRUE(next_token(stream).is_err());
 }
 
+TEST(tokenizer, unpaired_surrogates) {
+    for(auto input : {"\"\\ud83d\"", "\"\\ud83dx\"", "\"\\ude00\"", "\"\\ud83d\\u0041\"", "\"\\u12"}) {
+        stringstream stream(input);
+        EXPECT_TRUE(next_token(stream).is_err()) << input;
+    }
+}
+
 TEST(tokenizer, bad_literal) {
     stringstream stream("trfalse");
     EXPECT_TRUE(next_token(stream).is_err());
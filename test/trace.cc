@@ -0,0 +1,158 @@
+#include "trace.hh"
+#include "visitor.hh"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+struct event {
+    bool                     begin;
+    trace_phase              phase;
+    size_t                   bytes;
+    std::chrono::nanoseconds elapsed;
+};
+
+class recording_tracer : public tracer {
+  public:
+    void begin(trace_phase phase) override {
+        events.push_back({true, phase, 0, {}});
+    }
+
+    void end(trace_phase phase, size_t bytes, std::chrono::nanoseconds elapsed) override {
+        events.push_back({false, phase, bytes, elapsed});
+    }
+
+    size_t count(trace_phase phase) const {
+        size_t n = 0;
+        for(auto& e : events) {
+            n += e.begin && e.phase == phase;
+        }
+        return n;
+    }
+
+    // every span ends in the order it began
+    bool nested() const {
+        vector<trace_phase> open;
+        for(auto& e : events) {
+            if(e.begin) {
+                open.push_back(e.phase);
+            } else if(open.empty() || open.back() != e.phase) {
+                return false;
+            } else {
+                open.pop_back();
+            }
+        }
+        return open.empty();
+    }
+
+    vector<event> events;
+};
+
+class null_visitor : public visitor {
+  public:
+    void scalar(scalar_t) override {
+    }
+    void scalar(string_view, scalar_t) override {
+    }
+    void push_sequence() override {
+    }
+    void push_sequence(string_view) override {
+    }
+    void push_mapping() override {
+    }
+    void push_mapping(string_view) override {
+    }
+    void pop() override {
+    }
+};
+
+TEST(trace, load) {
+    string input = R"({"a": [1, 2], "b": "xyz"})";
+
+    recording_tracer t;
+    ASSERT_TRUE(load(input, t).is_ok());
+    ASSERT_TRUE(t.nested());
+
+    // one span per phase, the tokens and values summed inside the parse
+    ASSERT_EQ(6u, t.events.size());
+    EXPECT_EQ(trace_phase::e_parse, t.events[0].phase);
+    EXPECT_EQ(trace_phase::e_tokenize, t.events[1].phase);
+    EXPECT_EQ(trace_phase::e_tokenize, t.events[2].phase);
+    EXPECT_EQ(trace_phase::e_build, t.events[3].phase);
+    EXPECT_EQ(trace_phase::e_build, t.events[4].phase);
+    EXPECT_EQ(trace_phase::e_parse, t.events[5].phase);
+
+    // the values of 1, 2 and the 3 strings
+    EXPECT_EQ(7u, t.events[2].bytes);
+    // the string value
+    EXPECT_EQ(3u, t.events[4].bytes);
+    EXPECT_EQ(input.size(), t.events[5].bytes);
+
+    EXPECT_LE(t.events[2].elapsed + t.events[4].elapsed, t.events[5].elapsed);
+}
+
+TEST(trace, load_visitor) {
+    istringstream in("[1, [true], null] ");
+
+    recording_tracer t;
+    null_visitor     v;
+    ASSERT_TRUE(load(in, v, t).is_ok());
+    ASSERT_TRUE(t.nested());
+
+    EXPECT_EQ(1u, t.count(trace_phase::e_parse));
+    EXPECT_EQ(1u, t.count(trace_phase::e_tokenize));
+    EXPECT_EQ(0u, t.count(trace_phase::e_build));
+    EXPECT_EQ(in.str().size(), t.events.back().bytes);
+}
+
+TEST(trace, dump) {
+    auto doc = load(R"({"a": [1, 2, "x"]})").unwrap();
+
+    recording_tracer t;
+    ostringstream    out;
+    dump(doc, out, t);
+    ASSERT_TRUE(t.nested());
+
+    ASSERT_EQ(2u, t.events.size());
+    EXPECT_EQ(trace_phase::e_serialize, t.events.back().phase);
+    EXPECT_EQ(out.str().size(), t.events.back().bytes);
+    EXPECT_EQ(R"({"a":[1,2,"x"]})", out.str());
+}
+
+TEST(trace, scope) {
+    recording_tracer outer;
+    recording_tracer inner;
+
+    {
+        trace_scope s(outer);
+        load("1").unwrap();
+        {
+            trace_scope n(inner);
+            ostringstream out;
+            dump(load("[]").unwrap(), out);
+        }
+        load("2").unwrap();
+    }
+    load("3").unwrap();
+
+    EXPECT_EQ(2u, outer.count(trace_phase::e_parse));
+    EXPECT_EQ(0u, outer.count(trace_phase::e_serialize));
+    EXPECT_EQ(1u, inner.count(trace_phase::e_parse));
+    EXPECT_EQ(1u, inner.count(trace_phase::e_serialize));
+}
+
+TEST(trace, errors) {
+    recording_tracer t;
+    EXPECT_TRUE(load("[1, }", t).is_err());
+    EXPECT_TRUE(t.nested());
+    EXPECT_EQ(1u, t.count(trace_phase::e_parse));
+}
+
+} // namespace
+} // namespace kjson
@@ -0,0 +1,69 @@
+#include "json.hh"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+TEST(validate, valid) {
+    for(string_view input : {
+            "null",
+            " true ",
+            "-0.5e+10",
+            "[]",
+            "{}",
+            R"({"a": [1, 2.0, -3e4, "x", {"b": null}], "c": false})",
+            R"("escapes \" \\ \/ \b \f \n \r \t \u00e9")",
+            R"("\ud83d\ude00 \uD800\uDC00 \uffff")",
+            "\"\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80\"",
+        }) {
+        auto r = validate(input);
+        EXPECT_TRUE(r) << input << ": " << r.error << " at " << r.offset;
+    }
+}
+
+struct invalid_testcase {
+    string input;
+    size_t offset;
+};
+
+inline ostream& operator<<(ostream& o, invalid_testcase const& tc) {
+    return o << tc.input;
+}
+
+class validate_invalid : public testing::TestWithParam<invalid_testcase> {
+};
+
+TEST_P(validate_invalid, offset) {
+    auto r = validate(GetParam().input);
+    EXPECT_FALSE(r);
+    EXPECT_EQ(GetParam().offset, r.offset) << r.error;
+}
+
+INSTANTIATE_TEST_SUITE_P(validate, validate_invalid, testing::Values(invalid_testcase{"", 0}, invalid_testcase{"[1 2]", 3}, invalid_testcase{"[1,]", 3}, invalid_testcase{"{\"a\" 1}", 5}, invalid_testcase{"{1:2}", 1}, invalid_testcase{"01", 1}, invalid_testcase{"1.", 2}, invalid_testcase{"-", 1}, invalid_testcase{"tru", 0}, invalid_testcase{"\"abc", 4}, invalid_testcase{"\"\\x\"", 2}, invalid_testcase{"\"\\u12g4\"", 5}, invalid_testcase{"\"a\tb\"", 2}, invalid_testcase{"null x", 5}, invalid_testcase{"\"\xc3\"", 1}, invalid_testcase{"\"\xed\xa0\x80\"", 1}, invalid_testcase{"\"\xc0\xaf\"", 1}, invalid_testcase{"\"\xf4\x90\x80\x80\"", 1}, invalid_testcase{"\"\xff\"", 1}, invalid_testcase{"[\"\\ud800\"]", 8}, invalid_testcase{"[\"\\udc00\"]", 2}, invalid_testcase{"[\"\\ud800\\u0041\"]", 8}, invalid_testcase{"[\"\\udbff\\udbff\"]", 8}, invalid_testcase{"[\"\\ud800\\n\"]", 8}, invalid_testcase{"\"\\ud800\\udc0", 12}));
+
+TEST(validate, long_strings) {
+    string ascii(1000, 'x');
+    EXPECT_TRUE(validate("\"" + ascii + "\""));
+
+    string bad = "\"" + ascii + "\x80" + ascii + "\"";
+    auto   r   = validate(bad);
+    EXPECT_FALSE(r);
+    EXPECT_EQ(1001u, r.offset);
+
+    string control = "\"" + ascii + "\n\"";
+    EXPECT_EQ(1001u, validate(control).offset);
+}
+
+TEST(validate, stream) {
+    istringstream good(R"({"a": 1})");
+    EXPECT_TRUE(validate(good));
+
+    istringstream bad(R"({"a": })");
+    EXPECT_EQ(6u, validate(bad).offset);
+}
+
+} // namespace
+} // namespace kjson
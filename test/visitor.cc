@@ -0,0 +1,36 @@
+#include "visitor.hh"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace kjson {
+namespace {
+
+using namespace std;
+
+TEST(raw_number, valid) {
+    for(auto text : {"0", "-0", "12", "1.5", "-1.25e10", "1E+5", "2e-3"}) {
+        EXPECT_TRUE(raw_number{text}.valid()) << text;
+    }
+    for(auto text : {"", "-", "+1", "01", "1.", ".5", "1e", "1e+", "1.2.3", "0x1"}) {
+        EXPECT_FALSE(raw_number{text}.valid()) << text;
+    }
+}
+
+TEST(raw_number, value) {
+    EXPECT_EQ(18446744073709551615u, get<uint64_t>(raw_number{"18446744073709551615"}.value()));
+    EXPECT_EQ(-42, get<int64_t>(raw_number{"-42"}.value()));
+    EXPECT_EQ(1e5, get<double>(raw_number{"1E5"}.value()));
+    EXPECT_EQ(0.25, get<double>(raw_number{"0.25"}.value()));
+}
+
+TEST(raw_number, conversions) {
+    raw_number n{"-17"};
+    EXPECT_EQ(-17, n.as_int());
+    EXPECT_EQ(-17.0, n.as_float());
+
+    string long_text = "1" + string(80, '0');
+    EXPECT_EQ(1e80, raw_number{long_text}.as_float());
+}
+
+} // namespace
+} // namespace kjson